@@ -2,23 +2,156 @@
 
 #include "utils/window.hpp"
 #include "utils/fps_counter.hpp"
+#include "my_vulkan/workgroup_autotuner.hpp"
+#include "constants.hpp"
+#include <algorithm>
 #include <iostream>
+#include <format>
 
 namespace KRV {
 
-App::App() {}
+App::App(bool isAutotuneForced) {
+    WorkgroupAutotuner(WORKGROUP_SIZES_FILE_NAME).Apply(vulkanController,
+        isAutotuneForced ? WorkgroupAutotuner::TUNING::ALL : WorkgroupAutotuner::TUNING::NONE);
+}
 
 void App::RenderLoop() {
     FPSCounter fpsCounter;
     Window& window = Window::GetInstance();
     while (!window.ShouldClose()) {
-        window.PollEvents();
-        vulkanController.DrawFrame();
+        // Converged image is already presented, so the loop sleeps until input
+        if (vulkanController.IsConverged(camera) && !isRecording) {
+            window.WaitEvents();
+        } else {
+            window.PollEvents();
+        }
+        ProcessRenderModeSwitch(window.GetEvents());
+        ProcessToleranceChange(window.GetEvents());
+        ProcessInterleaveSwitch(window.GetEvents());
+        ProcessGovernorSwitch(window.GetEvents());
+        ProcessMarchingDispatchSwitch(window.GetEvents());
+        camera.Update(window.GetEvents());
+        ProcessPathRecording(window.GetEvents());
+        if (vulkanController.IsConverged(camera)) {
+            fpsCounter.Reset();
+            continue;
+        }
+        vulkanController.DrawFrame(camera);
         if (fpsCounter.GetTime() > 1.0F) {
             std::cout << fpsCounter.Reset() << std::endl;
+            for (auto const &timing : vulkanController.GetGPUTimings()) {
+                std::cout << std::format("{:>{}}{}: {:.3f} ms", "", 2U*(timing.depth + 1U), timing.name, timing.milliseconds) << std::endl;
+            }
         }
         fpsCounter.IncreaseNumOfFrames(1U);
     }
 }
 
+void App::ProcessRenderModeSwitch(Window::Events const &events) {
+    // Keys 1-7 select render mode in order of RENDER_MODE enum
+    bool const keys[RENDER_MODE_COUNT] = {
+        events.keyboard.NUM_1,
+        events.keyboard.NUM_2,
+        events.keyboard.NUM_3,
+        events.keyboard.NUM_4,
+        events.keyboard.NUM_5,
+        events.keyboard.NUM_6,
+        events.keyboard.NUM_7
+    };
+
+    for (uint32_t modeIdx = 0U; modeIdx < RENDER_MODE_COUNT; modeIdx++) {
+        bool const isPressed = keys[modeIdx] && !renderModeKeys[modeIdx];
+        renderModeKeys[modeIdx] = keys[modeIdx];
+
+        RENDER_MODE const renderMode = static_cast<RENDER_MODE>(modeIdx);
+        if (!isPressed || renderMode == vulkanController.GetRenderMode()) {
+            continue;
+        }
+
+        if (vulkanController.SetRenderMode(renderMode)) {
+            std::cout << std::format("Render mode: {}", GetRenderModeName(renderMode)) << std::endl;
+        }
+    }
+}
+
+void App::ProcessToleranceChange(Window::Events const &events) {
+    // '+' and '-' change tolerance of adaptive step mode by order of magnitude
+    float multiplier = 1.0F;
+    if (events.keyboard.PLUS && !isPlusPressed) {
+        multiplier = 10.0F;
+    } else if (events.keyboard.MINUS && !isMinusPressed) {
+        multiplier = 0.1F;
+    }
+
+    isPlusPressed = events.keyboard.PLUS;
+    isMinusPressed = events.keyboard.MINUS;
+
+    if (multiplier != 1.0F) {
+        float const tolerance = std::clamp(vulkanController.GetRK45Tolerance()*multiplier, 1.0e-8F, 1.0e-2F);
+        vulkanController.SetRK45Tolerance(tolerance);
+        std::cout << std::format("RK45 tolerance: {:.0e}", tolerance) << std::endl;
+    }
+}
+
+void App::ProcessInterleaveSwitch(Window::Events const &events) {
+    bool const isPressed = events.keyboard.T && !isInterleavePressed;
+    isInterleavePressed = events.keyboard.T;
+
+    if (isPressed) {
+        uint32_t const factor = (vulkanController.GetInterleaveFactor() == 4U) ? 1U : 2U*vulkanController.GetInterleaveFactor();
+        if (vulkanController.SetInterleaveFactor(factor)) {
+            std::cout << std::format("Interleave factor: {}", factor) << std::endl;
+        }
+    }
+}
+
+void App::ProcessGovernorSwitch(Window::Events const &events) {
+    bool const isPressed = events.keyboard.G && !isGovernorPressed;
+    isGovernorPressed = events.keyboard.G;
+
+    if (isPressed) {
+        double const target = (vulkanController.GetTargetFrameTime() > 0.0) ? 0.0 : TARGET_FRAME_TIME_MS;
+        vulkanController.SetTargetFrameTime(target);
+        if (target > 0.0) {
+            std::cout << std::format("Frame time governor: {:.2f} ms", target) << std::endl;
+        } else {
+            std::cout << "Frame time governor: off" << std::endl;
+        }
+    }
+}
+
+void App::ProcessMarchingDispatchSwitch(Window::Events const &events) {
+    bool const isPressed = events.keyboard.V && !isMarchingDispatchPressed;
+    isMarchingDispatchPressed = events.keyboard.V;
+
+    if (isPressed) {
+        RENDER_MODE const renderMode = vulkanController.GetRenderMode();
+        auto const dispatch = static_cast<MARCHING_DISPATCH>(
+            (static_cast<uint32_t>(vulkanController.GetMarchingDispatch(renderMode)) + 1U) % MARCHING_DISPATCH_COUNT);
+        if (vulkanController.SetMarchingDispatch(renderMode, dispatch)) {
+            std::cout << std::format("Marching dispatch: {}", GetMarchingDispatchName(dispatch)) << std::endl;
+        }
+    }
+}
+
+void App::ProcessPathRecording(Window::Events const &events) {
+    bool const isPressed = events.keyboard.R && !isRecordPressed;
+    isRecordPressed = events.keyboard.R;
+
+    if (isPressed) {
+        isRecording = !isRecording;
+        if (isRecording) {
+            recordedPath.Clear();
+            std::cout << "Camera path recording is started" << std::endl;
+        } else if (!recordedPath.IsEmpty()) {
+            recordedPath.Save(CAMERA_PATH_FILE_NAME);
+            std::cout << std::format("Camera path is saved into {} ({} poses)", CAMERA_PATH_FILE_NAME, recordedPath.GetSize()) << std::endl;
+        }
+    }
+
+    if (isRecording) {
+        recordedPath.AddPose(camera.GetPosition(), camera.GetDirection());
+    }
+}
+
 }
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "my_vulkan/vulkan_controller.hpp"
+#include "utils/window.hpp"
+#include "utils/camera.hpp"
+#include "utils/camera_path.hpp"
 
 namespace KRV {
 
 class App final {
 public:
-    App();
+    // Saved workgroup shapes are applied, other modes keep default ones.
+    // All shapes are tuned before the window becomes interactive if `isAutotuneForced` is true.
+    explicit App(bool isAutotuneForced = false);
 
     App(App const &) = delete;
     App& operator=(App const &) = delete;
@@ -18,7 +23,34 @@ public:
     void RenderLoop();
 
 private:
+    void ProcessRenderModeSwitch(Window::Events const &events);
+    void ProcessToleranceChange(Window::Events const &events);
+    void ProcessPathRecording(Window::Events const &events);
+    void ProcessInterleaveSwitch(Window::Events const &events);
+    void ProcessGovernorSwitch(Window::Events const &events);
+    void ProcessMarchingDispatchSwitch(Window::Events const &events);
+
     VulkanController vulkanController{};
+    Camera camera = Camera(glm::vec3(-0.3F, 0.3F, +0.05F), glm::vec3(1.0F, -1.0F, -0.2F), 0.1F, 1.0F, 1.57F);
+
+    // Previous state of render mode keys, mode is switched only on key press
+    bool renderModeKeys[RENDER_MODE_COUNT] = {};
+    bool isPlusPressed = false;
+    bool isMinusPressed = false;
+
+    // 'R' starts and stops recording of camera path for benchmark
+    CameraPath recordedPath{};
+    bool isRecording = false;
+    bool isRecordPressed = false;
+
+    // 'T' cycles interleave factor of ray marching: every pixel, checkerboard, 1 pixel of 2x2 block
+    bool isInterleavePressed = false;
+
+    // 'G' toggles frame time governor with TARGET_FRAME_TIME_MS target
+    bool isGovernorPressed = false;
+
+    // 'V' cycles dispatch of the current ray marching mode: grid, wavefront, persistent threads
+    bool isMarchingDispatchPressed = false;
 };
 
 }
@@ -0,0 +1,321 @@
+#include "constants.hpp"
+#include "my_vulkan/vulkan_controller.hpp"
+#include "my_vulkan/workgroup_autotuner.hpp"
+#include "utils/camera.hpp"
+#include "utils/camera_path.hpp"
+#include "utils/clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Deterministic benchmark: every render mode is driven along the same camera paths in headless mode.
+// Ray marching modes are run with every marching dispatch, unless --dispatch selects one of them.
+// Workgroup shapes are tuned once per device and driver, --autotune tunes them again.
+// Usage: bench [--frames N] [--warmup N] [--interleave N] [--target-frame-time ms] [--dispatch NAME] [--autotune] [--path recorded_path.txt] [--label text] [--output results.json]
+
+namespace {
+
+struct Options final {
+    uint32_t frames = 300U;
+    uint32_t warmupFrames = 30U;
+    uint32_t interleaveFactor = 1U;
+    // Zero disables frame time governor
+    double targetFrameTimeMs = 0.0;
+    // Empty one is all of them
+    std::vector<KRV::MARCHING_DISPATCH> marchingDispatches{};
+    bool isAutotuneForced = false;
+    std::string recordedPath = "";
+    std::string label = "";
+    std::string output = "bench_results.json";
+};
+
+struct Statistics final {
+    double meanMs = 0.0;
+    double medianMs = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    double stdDevMs = 0.0;
+};
+
+struct PassTiming final {
+    std::string name;
+    double meanMs = 0.0;
+};
+
+struct Result final {
+    std::string mode;
+    std::string dispatch;
+    VkExtent2D workgroupSize = {};
+    std::string scenario;
+    bool isSupported = false;
+    Statistics statistics{};
+    std::vector<PassTiming> passTimings{};
+};
+
+Options ParseOptions(int argc, char **argv) {
+    Options options{};
+
+    for (int i = 1; i < argc; i++) {
+        auto const nextArg = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(std::format("Missing value of argument {}", argv[i]));
+            }
+            return argv[++i];
+        };
+
+        if (std::strcmp(argv[i], "--frames") == 0) {
+            options.frames = std::max(static_cast<uint32_t>(std::stoul(nextArg())), 1U);
+        } else if (std::strcmp(argv[i], "--warmup") == 0) {
+            options.warmupFrames = static_cast<uint32_t>(std::stoul(nextArg()));
+        } else if (std::strcmp(argv[i], "--interleave") == 0) {
+            options.interleaveFactor = static_cast<uint32_t>(std::stoul(nextArg()));
+        } else if (std::strcmp(argv[i], "--target-frame-time") == 0) {
+            options.targetFrameTimeMs = std::stod(nextArg());
+        } else if (std::strcmp(argv[i], "--dispatch") == 0) {
+            std::string const name = nextArg();
+            auto const it = std::ranges::find(KRV::MARCHING_DISPATCH_NAMES, name);
+            if (it == std::end(KRV::MARCHING_DISPATCH_NAMES)) {
+                throw std::runtime_error(std::format("Unknown marching dispatch {}", name));
+            }
+            options.marchingDispatches = {static_cast<KRV::MARCHING_DISPATCH>(it - std::begin(KRV::MARCHING_DISPATCH_NAMES))};
+        } else if (std::strcmp(argv[i], "--autotune") == 0) {
+            options.isAutotuneForced = true;
+        } else if (std::strcmp(argv[i], "--path") == 0) {
+            options.recordedPath = nextArg();
+        } else if (std::strcmp(argv[i], "--label") == 0) {
+            options.label = nextArg();
+        } else if (std::strcmp(argv[i], "--output") == 0) {
+            options.output = nextArg();
+        } else {
+            throw std::runtime_error(std::format("Unknown argument {}", argv[i]));
+        }
+    }
+
+    return options;
+}
+
+Statistics ComputeStatistics(std::vector<double> frameTimesMs) {
+    Statistics statistics{};
+
+    std::ranges::sort(frameTimesMs);
+    auto const percentile = [&frameTimesMs](double p){
+        size_t const idx = static_cast<size_t>(std::ceil(p*static_cast<double>(frameTimesMs.size()))) - 1U;
+        return frameTimesMs[std::min(idx, frameTimesMs.size() - 1U)];
+    };
+
+    double const count = static_cast<double>(frameTimesMs.size());
+    statistics.meanMs = std::accumulate(frameTimesMs.begin(), frameTimesMs.end(), 0.0)/count;
+    statistics.medianMs = percentile(0.5);
+    statistics.p95Ms = percentile(0.95);
+    statistics.p99Ms = percentile(0.99);
+    statistics.minMs = frameTimesMs.front();
+    statistics.maxMs = frameTimesMs.back();
+
+    double variance = 0.0;
+    for (double const frameTimeMs : frameTimesMs) {
+        variance += (frameTimeMs - statistics.meanMs)*(frameTimeMs - statistics.meanMs);
+    }
+    statistics.stdDevMs = std::sqrt(variance/count);
+
+    return statistics;
+}
+
+// Frames are pipelined, so the time between two DrawFrame calls is the frame time of steady state.
+// GPU time of every pass is averaged over the measured frames.
+Statistics RunPath(KRV::VulkanController &vulkanController, KRV::CameraPath const &path, Options const &options,
+    std::vector<PassTiming> &passTimings) {
+    KRV::Camera camera(glm::vec3(1.0F), glm::vec3(-1.0F), 0.0F, 0.0F, 1.57F);
+
+    // Precomputed tables are generated by slices over frames, so warmup lasts until the mode is ready
+    for (uint32_t i = 0U; i < options.warmupFrames || !vulkanController.IsRenderModeReady(); i++) {
+        auto const &pose = path.GetPose(i);
+        camera.SetPose(pose.position, pose.direction);
+        vulkanController.DrawFrame(camera);
+    }
+    vulkanController.FlushFrames();
+
+    std::vector<double> frameTimesMs;
+    frameTimesMs.reserve(options.frames);
+
+    std::vector<uint32_t> passSamples;
+    auto const accumulatePassTimings = [&](){
+        for (auto const &timing : vulkanController.GetGPUTimings()) {
+            auto it = std::ranges::find(passTimings, timing.name, &PassTiming::name);
+            if (it == passTimings.end()) {
+                passTimings.push_back(PassTiming{.name = timing.name});
+                passSamples.push_back(0U);
+                it = std::prev(passTimings.end());
+            }
+            it->meanMs += timing.milliseconds;
+            passSamples[static_cast<size_t>(it - passTimings.begin())]++;
+        }
+    };
+
+    KRV::Clock clock;
+    for (uint32_t i = 0U; i < options.frames; i++) {
+        auto const &pose = path.GetPose(i);
+        camera.SetPose(pose.position, pose.direction);
+        vulkanController.DrawFrame(camera);
+        frameTimesMs.push_back(clock.Reset()*1000.0);
+        accumulatePassTimings();
+    }
+
+    // Frames in flight are finished only here, so the tail is distributed over the last frame.
+    vulkanController.FlushFrames();
+    frameTimesMs.back() += clock.Reset()*1000.0;
+
+    for (size_t i = 0U; i < passTimings.size(); i++) {
+        passTimings[i].meanMs /= static_cast<double>(passSamples[i]);
+    }
+
+    return ComputeStatistics(std::move(frameTimesMs));
+}
+
+std::string EscapeJSON(std::string const &str) {
+    std::string ret;
+    for (char const c : str) {
+        if (c == '"' || c == '\\') {
+            ret.push_back('\\');
+        }
+        ret.push_back(c);
+    }
+    return ret;
+}
+
+void WriteJSON(std::string const &fileName, Options const &options, std::string const &deviceName,
+    double timeToFirstFrameMs, std::vector<Result> const &results) {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        throw std::runtime_error(std::format("Cannot open file {}", fileName));
+    }
+
+    file << "{\n";
+    file << std::format("    \"device\": \"{}\",\n", EscapeJSON(deviceName));
+    file << std::format("    \"label\": \"{}\",\n", EscapeJSON(options.label));
+    file << std::format("    \"resolution\": [{}, {}],\n", KRV::WINDOW_SIZE_WIDTH, KRV::WINDOW_SIZE_HEIGHT);
+    file << std::format("    \"frames\": {},\n", options.frames);
+    file << std::format("    \"warmupFrames\": {},\n", options.warmupFrames);
+    file << std::format("    \"interleaveFactor\": {},\n", options.interleaveFactor);
+    file << std::format("    \"targetFrameTimeMs\": {:.4f},\n", options.targetFrameTimeMs);
+    file << std::format("    \"timeToFirstFrameMs\": {:.4f},\n", timeToFirstFrameMs);
+    file << "    \"results\": [\n";
+
+    for (size_t i = 0U; i < results.size(); i++) {
+        auto const &result = results[i];
+        auto const &stat = result.statistics;
+        file << std::format("        {{\"mode\": \"{}\", \"dispatch\": \"{}\", \"workgroupSize\": [{}, {}], \"scenario\": \"{}\", \"supported\": {}",
+            result.mode, result.dispatch, result.workgroupSize.width, result.workgroupSize.height,
+            EscapeJSON(result.scenario), result.isSupported);
+        if (result.isSupported) {
+            file << std::format(", \"meanMs\": {:.4f}, \"medianMs\": {:.4f}, \"p95Ms\": {:.4f}, \"p99Ms\": {:.4f}"
+                ", \"minMs\": {:.4f}, \"maxMs\": {:.4f}, \"stdDevMs\": {:.4f}",
+                stat.meanMs, stat.medianMs, stat.p95Ms, stat.p99Ms, stat.minMs, stat.maxMs, stat.stdDevMs);
+
+            file << ", \"gpuPassesMs\": {";
+            for (size_t j = 0U; j < result.passTimings.size(); j++) {
+                file << std::format("{}\"{}\": {:.4f}", (j == 0U) ? "" : ", ", result.passTimings[j].name, result.passTimings[j].meanMs);
+            }
+            file << "}";
+        }
+        file << ((i + 1U < results.size()) ? "},\n" : "}\n");
+    }
+
+    file << "    ]\n";
+    file << "}\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+    try {
+        Options const options = ParseOptions(argc, argv);
+
+        std::vector<std::pair<std::string, KRV::CameraPath>> paths;
+        for (uint32_t i = 0U; i < KRV::CameraPath::SCENARIO_COUNT; i++) {
+            auto const scenario = static_cast<KRV::CameraPath::SCENARIO>(i);
+            paths.emplace_back(KRV::CameraPath::GetScenarioName(scenario), KRV::CameraPath::FromScenario(scenario, options.frames));
+        }
+        if (!options.recordedPath.empty()) {
+            paths.emplace_back(std::format("RECORDED:{}", options.recordedPath), KRV::CameraPath::Load(options.recordedPath));
+        }
+
+        KRV::VulkanController vulkanController(true);
+        std::string const deviceName = vulkanController.GetDeviceName();
+        std::cout << std::format("Device: {}", deviceName) << std::endl;
+
+        // Bench is an explicit measurement, so modes without saved shapes are tuned here
+        KRV::WorkgroupAutotuner(KRV::WORKGROUP_SIZES_FILE_NAME).Apply(vulkanController, options.isAutotuneForced ?
+            KRV::WorkgroupAutotuner::TUNING::ALL : KRV::WorkgroupAutotuner::TUNING::MISSING);
+
+        // Every frame is rendered with its full cost, even if the camera stops
+        vulkanController.SetProgressiveRefinement(false);
+
+        if (!vulkanController.SetInterleaveFactor(options.interleaveFactor)) {
+            throw std::runtime_error(std::format("Unsupported interleave factor {}", options.interleaveFactor));
+        }
+
+        std::vector<KRV::MARCHING_DISPATCH> marchingDispatches = options.marchingDispatches;
+        if (marchingDispatches.empty()) {
+            for (uint32_t dispatchIdx = 0U; dispatchIdx < KRV::MARCHING_DISPATCH_COUNT; dispatchIdx++) {
+                marchingDispatches.push_back(static_cast<KRV::MARCHING_DISPATCH>(dispatchIdx));
+            }
+        }
+
+        std::vector<Result> results;
+        for (uint32_t modeIdx = 0U; modeIdx < KRV::RENDER_MODE_COUNT; modeIdx++) {
+            auto const renderMode = static_cast<KRV::RENDER_MODE>(modeIdx);
+            bool const isSupported = vulkanController.SetRenderMode(renderMode);
+
+            // Other modes don't march rays, so they have only the grid dispatch
+            bool const isRayMarching = KRV::IsRayMarchingMode(renderMode);
+            size_t const dispatchCount = isRayMarching ? marchingDispatches.size() : 1U;
+
+            for (size_t dispatchIdx = 0U; dispatchIdx < dispatchCount; dispatchIdx++) {
+                auto const marchingDispatch = isRayMarching ? marchingDispatches[dispatchIdx] : KRV::MARCHING_DISPATCH::GRID;
+                if (isRayMarching) {
+                    vulkanController.SetMarchingDispatch(renderMode, marchingDispatch);
+                }
+
+                for (auto const &[scenarioName, path] : paths) {
+                    Result result {
+                        .mode = KRV::GetRenderModeName(renderMode),
+                        .dispatch = KRV::GetMarchingDispatchName(marchingDispatch),
+                        .workgroupSize = vulkanController.GetWorkgroupSize(renderMode),
+                        .scenario = scenarioName,
+                        .isSupported = isSupported
+                    };
+
+                    if (isSupported) {
+                        // Every run starts from the full quality
+                        vulkanController.SetTargetFrameTime(options.targetFrameTimeMs);
+                        result.statistics = RunPath(vulkanController, path, options, result.passTimings);
+                        std::cout << std::format("{:<20} {:<18} {:<24} mean {:8.3f} ms, median {:8.3f} ms, p95 {:8.3f} ms",
+                            result.mode, result.dispatch, result.scenario, result.statistics.meanMs, result.statistics.medianMs,
+                            result.statistics.p95Ms) << std::endl;
+                    }
+
+                    results.push_back(std::move(result));
+                }
+            }
+        }
+
+        // The first frame is drawn by the autotuner or by the first run, startup cost is measured up to it
+        WriteJSON(options.output, options, deviceName, vulkanController.GetTimeToFirstFrame(), results);
+        std::cout << std::format("Results are written into {}", options.output) << std::endl;
+    } catch (std::exception const &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
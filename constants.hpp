@@ -22,6 +22,18 @@ constexpr float WINDOW_SIZE_WIDTH_F = static_cast<float>(WINDOW_SIZE_WIDTH);
 constexpr uint32_t WINDOW_SIZE_HEIGHT = 800U;
 constexpr float WINDOW_SIZE_HEIGHT_F = static_cast<float>(WINDOW_SIZE_HEIGHT);
 
+// Frames recorded while previous ones are executed. Resources reused by frames are rings of this size.
+constexpr uint32_t FRAMES_IN_FLIGHT = 2U;
+
+// Target GPU frame time of the frame time governor in the application
+constexpr double TARGET_FRAME_TIME_MS = 1000.0/60.0;
+
+// Camera path recorded in the application and replayed by benchmark
+constexpr char const *CAMERA_PATH_FILE_NAME = "camera_path.txt";
+
+// Workgroup shapes of render modes, which are tuned per device in the application and benchmark
+constexpr char const *WORKGROUP_SIZES_FILE_NAME = "workgroup_sizes.txt";
+
 // vendorID
 constexpr uint32_t AMD_VENDOR_ID = 0x1002;
 constexpr uint32_t NVIDIA_VENDOR_ID = 0x10DE;
@@ -1,7 +1,12 @@
 #include <app.hpp>
 
-int main() {
-    KRV::App app;
+#include <cstring>
+
+int main(int argc, char **argv) {
+    // Saved workgroup shapes are applied, --autotune tunes all of them and saves them
+    bool const isAutotuneForced = (argc > 1 && std::strcmp(argv[1], "--autotune") == 0);
+
+    KRV::App app(isAutotuneForced);
     app.RenderLoop();
 
     return 0;
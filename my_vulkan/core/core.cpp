@@ -1,28 +1,52 @@
 #include "core.hpp"
 
 #include "passes/black_hole/black_hole_pass.hpp"
+#include "passes/black_hole/black_hole_precompute_pass.hpp"
 
-#ifdef BLACK_HOLE_PRECOMPUTED
+#include "my_vulkan/vulkan_functions.hpp"
 
-#include "passes/black_hole/black_hole_precompute_pass.hpp"
+#include <exception>
+#include <iostream>
+#include <format>
+
+namespace {
 
-#endif // BLACK_HOLE_PRECOMPUTED
+constexpr char const *pipelineCacheFileName = "pipeline.cache";
+
+}
 
 namespace KRV {
 
-Core::Core() {
+void Core::LoadAssets(JobSystem &jobSystem, VkPhysicalDevice physicalDevice, bool isRayQuerySupported) {
+    assets.Load(jobSystem, physicalDevice, isRayQuerySupported);
+}
+
+void Core::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t apiVersion, bool isRayQuerySupported, bool isPrecomputedSupported,
+    BlackHoleSpecialization const &specialization, JobSystem &jobSystem) {
+    this->isRayQuerySupported = isRayQuerySupported;
+    this->isPrecomputedSupported = isPrecomputedSupported;
 
-#ifdef BLACK_HOLE_PRECOMPUTED
+    if (!SetRenderMode(renderMode)) {
+        renderMode = RENDER_MODE::RAY_MARCHING_RK4;
+    }
 
-    passes.emplace_back(std::make_unique<BlackHolePrecomputePass>());
+    // Precompute Pass. It is recorded only when the precomputed mode is used, until tables are ready and cached.
+    // Slices of its generation are timed on graphics and async compute queues, so both must support timestamps.
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    double const timestampPeriodMs = properties.limits.timestampComputeAndGraphics ?
+        static_cast<double>(properties.limits.timestampPeriod)*1.0e-6 : 0.0;
 
-#endif // BLACK_HOLE_PRECOMPUTED
+    auto pPrecomputePass = std::make_unique<BlackHolePrecomputePass>(physicalDevice, specialization, timestampPeriodMs,
+        isPrecomputedSupported);
+    pBlackHolePrecomputePass = pPrecomputePass.get();
+    passes.emplace_back(std::move(pPrecomputePass));
 
     // Black Hole Pass
-    passes.emplace_back(std::make_unique<BlackHolePass>());
-}
+    auto pPass = std::make_unique<BlackHolePass>(isRayQuerySupported, specialization, assets);
+    pBlackHolePass = pPass.get();
+    passes.emplace_back(std::move(pPass));
 
-void Core::Init(VkPhysicalDevice physicalDevice, VkDevice device) {
     // Firstly, allocate Vulkan resources
     gpuAllocator.Init(physicalDevice);
     for (auto &pPass : passes) {
@@ -30,27 +54,184 @@ void Core::Init(VkPhysicalDevice physicalDevice, VkDevice device) {
     }
     gpuAllocator.PresentResources(device);
 
-    // Secondly, just init passes
+    // Secondly, just init passes. Pipelines are taken from the cache of the previous launch.
+    // Passes are independent, so they are initialized by jobs at once.
+    pipelineCache.Init(physicalDevice, device, apiVersion, pipelineCacheFileName);
+    JobSystem::Group passesGroup{};
     for (auto &pPass : passes) {
-        pPass->Init(device);
+        jobSystem.Submit(passesGroup, [&pPass, &jobSystem, device, this](){
+            pPass->Init(device, pipelineCache.Get(), jobSystem);
+        });
     }
+    jobSystem.Wait(passesGroup);
+
+    pBlackHolePass->SetRenderMode(renderMode);
+    SetRK45Tolerance(RK45_DEFAULT_TOLERANCE);
 }
 
 void Core::Destroy(VkDevice device) {
+    // Jobs write into assets, so they are finished even if the first frame is not drawn.
+    // It is called by the destructor of VulkanController, so failed jobs are only reported.
+    try {
+        assets.Wait();
+    } catch (std::exception const &e) {
+        std::cerr << std::format("[Core] Loading of assets failed: {}\n", e.what());
+    }
+
     for (auto &pPass : passes) {
         pPass->Destroy(device);
     }
 
+    pipelineCache.Destroy(device);
     gpuAllocator.Destroy(device);
 }
 
-Image& Core::RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer) {
-    for (auto &pPass : passes) {
-        pPass->RecordCommandBuffer(device, commandBuffer);
+Image& Core::RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer, Camera const &camera) {
+    if (renderMode == RENDER_MODE::PRECOMPUTED) {
+        pBlackHolePrecomputePass->RecordCommandBuffer(device, commandBuffer);
+
+        // Tables are streamed from the cache file or generated by async compute, the image is ray marched meanwhile
+        pBlackHolePass->SetRenderMode(pBlackHolePrecomputePass->IsReady() ? RENDER_MODE::PRECOMPUTED : RENDER_MODE::RAY_MARCHING_RK4);
+    }
+
+    FrameTimeGovernor::Settings const &frameSettings = frameTimeGovernor.GetSettings();
+    pBlackHolePass->SetFrameSettings(frameSettings.renderExtent, frameSettings.stepScale);
+    pBlackHolePass->SetCameraPose(camera.GetPosition(), camera.GetDirection());
+    pBlackHolePass->RecordCommandBuffer(device, commandBuffer);
+
+    return pBlackHolePass->GetFinalImage();
+}
+
+void Core::RecordUpload(VkDevice device, VkCommandBuffer commandBuffer, uint32_t transferQueueFamilyIndex, uint32_t queueFamilyIndex) {
+    pBlackHolePass->RecordUpload(device, commandBuffer, transferQueueFamilyIndex, queueFamilyIndex);
+}
+
+bool Core::HasAsyncCompute() const {
+    return renderMode == RENDER_MODE::PRECOMPUTED && pBlackHolePrecomputePass->IsGenerationNeeded();
+}
+
+void Core::RecordAsyncCompute(VkDevice device, VkCommandBuffer commandBuffer, uint32_t computeQueueFamilyIndex, uint32_t queueFamilyIndex) {
+    pBlackHolePrecomputePass->RecordAsyncGeneration(device, commandBuffer, computeQueueFamilyIndex, queueFamilyIndex);
+}
+
+void Core::FinishAsyncCompute() {
+    pBlackHolePrecomputePass->FinishAsyncGeneration();
+}
+
+bool Core::SetRenderMode(RENDER_MODE renderMode) {
+    if (!IsRenderModeSupported(renderMode)) {
+        std::cerr << std::format("[Core] Render mode {} is not supported by the device\n", GetRenderModeName(renderMode));
+        return false;
+    }
+
+    this->renderMode = renderMode;
+    if (pBlackHolePass != nullptr) {
+        pBlackHolePass->SetRenderMode(renderMode);
+    }
+
+    return true;
+}
+
+RENDER_MODE Core::GetRenderMode() const {
+    return renderMode;
+}
+
+void Core::SetRK45Tolerance(float tolerance) {
+    rk45Tolerance = tolerance;
+    pBlackHolePass->SetRK45Tolerance(tolerance);
+}
+
+float Core::GetRK45Tolerance() const {
+    return rk45Tolerance;
+}
+
+bool Core::SetInterleaveFactor(uint32_t factor) {
+    if (factor != 1U && factor != 2U && factor != 4U) {
+        std::cerr << std::format("[Core] Interleave factor {} is not supported\n", factor);
+        return false;
+    }
+
+    interleaveFactor = factor;
+    pBlackHolePass->SetInterleaveFactor(factor);
+
+    return true;
+}
+
+uint32_t Core::GetInterleaveFactor() const {
+    return interleaveFactor;
+}
+
+void Core::SetProgressiveRefinement(bool isEnabled) {
+    pBlackHolePass->SetProgressiveRefinement(isEnabled);
+}
+
+bool Core::IsConverged(Camera const &camera) const {
+    // Tables are still streamed, so frames must be recorded
+    if (!IsRenderModeReady()) {
+        return false;
+    }
+
+    return pBlackHolePass->IsConverged(camera.GetPosition(), camera.GetDirection());
+}
+
+bool Core::SetMarchingDispatch(RENDER_MODE renderMode, MARCHING_DISPATCH marchingDispatch) {
+    if (!IsRayMarchingMode(renderMode)) {
+        std::cerr << std::format("[Core] Render mode {} doesn't march rays\n", GetRenderModeName(renderMode));
+        return false;
+    }
+
+    pBlackHolePass->SetMarchingDispatch(renderMode, marchingDispatch);
+
+    return true;
+}
+
+MARCHING_DISPATCH Core::GetMarchingDispatch(RENDER_MODE renderMode) const {
+    return pBlackHolePass->GetMarchingDispatch(renderMode);
+}
+
+bool Core::SetWorkgroupSize(VkDevice device, RENDER_MODE renderMode, VkExtent2D workgroupSize) {
+    if (!IsRenderModeSupported(renderMode)) {
+        std::cerr << std::format("[Core] Render mode {} is not supported by the device\n", GetRenderModeName(renderMode));
+        return false;
     }
 
-    // TODO: Change it!
-    return static_cast<BlackHolePass*>(passes.back().get())->GetFinalImage();
+    pBlackHolePass->SetWorkgroupSize(device, renderMode, workgroupSize);
+
+    return true;
+}
+
+VkExtent2D Core::GetWorkgroupSize(RENDER_MODE renderMode) const {
+    return pBlackHolePass->GetWorkgroupSize(renderMode);
+}
+
+bool Core::IsRenderModeSupported(RENDER_MODE renderMode) const {
+    return (renderMode != RENDER_MODE::RAY_QUERY || isRayQuerySupported) &&
+        (renderMode != RENDER_MODE::PRECOMPUTED || isPrecomputedSupported);
+}
+
+bool Core::IsRenderModeReady() const {
+    return renderMode != RENDER_MODE::PRECOMPUTED || pBlackHolePrecomputePass->IsReady();
+}
+
+void Core::SetTargetFrameTime(double milliseconds) {
+    frameTimeGovernor.SetTargetFrameTime(milliseconds);
+}
+
+double Core::GetTargetFrameTime() const {
+    return frameTimeGovernor.GetTargetFrameTime();
+}
+
+void Core::UpdateFrameTime(double gpuMilliseconds) {
+    // Refined frames are rendered in the full quality regardless of their time
+    if (pBlackHolePass->IsRefining()) {
+        return;
+    }
+
+    frameTimeGovernor.Update(gpuMilliseconds);
+}
+
+VkExtent2D Core::GetRenderExtent() const {
+    return pBlackHolePass->GetRenderExtent();
 }
 
 }
@@ -2,13 +2,23 @@
 
 #include <memory>
 #include "my_vulkan/gpu_allocator.hpp"
+#include "my_vulkan/pipeline_cache.hpp"
 #include "passes/base_pass.hpp"
+#include "render_mode.hpp"
+#include "frame_time_governor.hpp"
+#include "passes/black_hole/black_hole_specialization.hpp"
+#include "passes/black_hole/black_hole_assets.hpp"
+#include "utils/job_system.hpp"
+#include "utils/camera.hpp"
 
 namespace KRV {
 
+class BlackHolePrecomputePass;
+class BlackHolePass;
+
 class Core final {
 public:
-    Core();
+    Core() = default;
 
     Core(Core const &) = delete;
     Core& operator=(Core const &) = delete;
@@ -17,17 +27,90 @@ public:
 
     ~Core() = default;
 
-    void Init(VkPhysicalDevice physicalDevice, VkDevice device);
+    // Files of passes are decoded by jobs, while the rest of Vulkan is initialized
+    void LoadAssets(JobSystem &jobSystem, VkPhysicalDevice physicalDevice, bool isRayQuerySupported);
+
+    // Specialization constants are given to all pipelines of passes. Pipelines are compiled by jobs.
+    // Unsupported RAY_QUERY and PRECOMPUTED modes are rejected by SetRenderMode.
+    void Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t apiVersion, bool isRayQuerySupported, bool isPrecomputedSupported,
+        BlackHoleSpecialization const &specialization, JobSystem &jobSystem);
 
     void Destroy(VkDevice device);
 
-    Image& RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer);
+    Image& RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer, Camera const &camera);
+    // Copies of assets into the command buffer of a dedicated transfer queue. Ownership of resources is released
+    // to the queue family of frames, so the first frame must wait for this submission.
+    void RecordUpload(VkDevice device, VkCommandBuffer commandBuffer, uint32_t transferQueueFamilyIndex, uint32_t queueFamilyIndex);
+
+    // Generation of precomputed tables on an async compute queue, frames are ray marched until it is finished.
+    // Tables are generated by slices, one submission per slice. Return value of HasAsyncCompute is true
+    // if the next slice is needed by the current mode and no slice is in flight.
+    bool HasAsyncCompute() const;
+    void RecordAsyncCompute(VkDevice device, VkCommandBuffer commandBuffer, uint32_t computeQueueFamilyIndex, uint32_t queueFamilyIndex);
+    // The async compute queue has signaled completion of a slice, so the next frame must wait for its timeline value
+    void FinishAsyncCompute();
+
+    // Return value is false if the mode is not supported
+    bool SetRenderMode(RENDER_MODE renderMode);
+    RENDER_MODE GetRenderMode() const;
+
+    // Local error tolerance of RAY_MARCHING_RK45 mode
+    void SetRK45Tolerance(float tolerance);
+    float GetRK45Tolerance() const;
+
+    // 1 of factor pixels is ray marched per frame, the rest are reprojected. Supported factors are 1, 2 and 4.
+    // Return value is false if the factor is not supported
+    bool SetInterleaveFactor(uint32_t factor);
+    uint32_t GetInterleaveFactor() const;
+
+    // Static camera image is refined progressively, it is enabled by default
+    void SetProgressiveRefinement(bool isEnabled);
+    // Return value is true if rendering of the camera pose changes nothing, so the frame may be skipped
+    bool IsConverged(Camera const &camera) const;
+
+    // Distribution of rays of a ray marching mode over invocations, wavefront is the default one.
+    // Return value is false if the mode doesn't march rays
+    bool SetMarchingDispatch(RENDER_MODE renderMode, MARCHING_DISPATCH marchingDispatch);
+    MARCHING_DISPATCH GetMarchingDispatch(RENDER_MODE renderMode) const;
+
+    // Workgroup shape of a render mode, its pipeline is rebuilt, so the device must be idle.
+    // Return value is false if the mode is not supported
+    bool SetWorkgroupSize(VkDevice device, RENDER_MODE renderMode, VkExtent2D workgroupSize);
+    VkExtent2D GetWorkgroupSize(RENDER_MODE renderMode) const;
+
+    // Return value is false while the current mode is substituted, e.g. precomputed tables are still streamed
+    bool IsRenderModeReady() const;
+
+    // Render resolution and integration step are scaled to keep GPU frame time near the target.
+    // Zero target disables the governor, it is disabled by default.
+    void SetTargetFrameTime(double milliseconds);
+    double GetTargetFrameTime() const;
+    // Measured GPU time of the last completed frame, it drives the governor
+    void UpdateFrameTime(double gpuMilliseconds);
+    // Part of the final image, which is rendered by the last recorded frame
+    VkExtent2D GetRenderExtent() const;
 
 private:
+    bool IsRenderModeSupported(RENDER_MODE renderMode) const;
+
     Utils::GPUAllocator gpuAllocator{};
+    // Shared by pipelines of all passes, it is saved on destruction
+    Utils::PipelineCache pipelineCache{};
+    BlackHoleAssets assets{};
+
+    bool isRayQuerySupported = false;
+    bool isPrecomputedSupported = false;
+    RENDER_MODE renderMode = DEFAULT_RENDER_MODE;
+    float rk45Tolerance = 0.0F;
+    uint32_t interleaveFactor = 1U;
+    FrameTimeGovernor frameTimeGovernor{};
 
     // Passes
     std::vector<std::unique_ptr<BasePass>> passes{};
+
+    // Non-owning pointers for pass specific calls
+    BlackHolePrecomputePass *pBlackHolePrecomputePass = nullptr;
+    BlackHolePass *pBlackHolePass = nullptr;
 };
 
 }
@@ -0,0 +1,80 @@
+#include "frame_time_governor.hpp"
+
+#include "my_vulkan/shaders/black_hole.in"
+
+#include <algorithm>
+#include <cmath>
+
+namespace KRV {
+
+namespace {
+
+// Weight of the last frame in the smoothed frame time
+constexpr double FRAME_TIME_SMOOTHING = 0.2;
+// Frame time in [LOW, HIGH]*target keeps settings unchanged, it prevents oscillation
+constexpr double DEAD_BAND_LOW = 0.85;
+constexpr double DEAD_BAND_HIGH = 1.0;
+// Middle of the dead band is the goal of every correction
+constexpr double DEAD_BAND_MIDDLE = 0.5*(DEAD_BAND_LOW + DEAD_BAND_HIGH);
+// Limits of a single correction, so spikes don't drop quality at once
+constexpr double MIN_CORRECTION = 0.8;
+constexpr double MAX_CORRECTION = 1.1;
+
+// Fraction of the window size per axis
+constexpr double MIN_RESOLUTION_SCALE = 0.5;
+constexpr double MAX_STEP_SCALE = 2.0;
+constexpr double MIN_RESOLUTION_COST = MIN_RESOLUTION_SCALE*MIN_RESOLUTION_SCALE;
+constexpr double MIN_COST_SCALE = MIN_RESOLUTION_COST/MAX_STEP_SCALE;
+
+uint32_t QuantizeExtent(double scale, uint32_t size) {
+    uint32_t const blocks = static_cast<uint32_t>(std::round(scale*size/RENDER_EXTENT_GRANULARITY));
+    return std::clamp(blocks, 1U, size/RENDER_EXTENT_GRANULARITY)*RENDER_EXTENT_GRANULARITY;
+}
+
+}
+
+void FrameTimeGovernor::SetTargetFrameTime(double milliseconds) {
+    targetFrameTime = std::max(milliseconds, 0.0);
+    smoothedFrameTime = 0.0;
+    costScale = 1.0;
+    UpdateSettings();
+}
+
+double FrameTimeGovernor::GetTargetFrameTime() const {
+    return targetFrameTime;
+}
+
+void FrameTimeGovernor::Update(double gpuMilliseconds) {
+    if (targetFrameTime <= 0.0 || gpuMilliseconds <= 0.0) {
+        return;
+    }
+
+    smoothedFrameTime = (smoothedFrameTime == 0.0) ? gpuMilliseconds
+        : std::lerp(smoothedFrameTime, gpuMilliseconds, FRAME_TIME_SMOOTHING);
+
+    double const ratio = smoothedFrameTime/targetFrameTime;
+    if (ratio >= DEAD_BAND_LOW && ratio <= DEAD_BAND_HIGH) {
+        return;
+    }
+
+    double const correction = std::clamp(DEAD_BAND_MIDDLE/ratio, MIN_CORRECTION, MAX_CORRECTION);
+    costScale = std::clamp(costScale*correction, MIN_COST_SCALE, 1.0);
+    UpdateSettings();
+}
+
+FrameTimeGovernor::Settings const& FrameTimeGovernor::GetSettings() const {
+    return settings;
+}
+
+void FrameTimeGovernor::UpdateSettings() {
+    double const resolutionCost = std::max(costScale, MIN_RESOLUTION_COST);
+    double const resolutionScale = std::sqrt(resolutionCost);
+
+    settings.renderExtent = {
+        QuantizeExtent(resolutionScale, WINDOW_SIZE_WIDTH),
+        QuantizeExtent(resolutionScale, WINDOW_SIZE_HEIGHT)
+    };
+    settings.stepScale = static_cast<float>(resolutionCost/costScale);
+}
+
+}
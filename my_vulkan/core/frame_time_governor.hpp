@@ -0,0 +1,37 @@
+#pragma once
+
+#include "constants.hpp"
+
+namespace KRV {
+
+// Keeps GPU frame time near the target by scaling the render resolution and then the integration step.
+// Cost of a frame is assumed proportional to the number of rays times the number of steps per ray,
+// so one multiplicative cost scale drives both: resolution goes down first, the step grows after the minimal resolution.
+class FrameTimeGovernor final {
+public:
+    struct Settings {
+        // Part of the final image, a multiple of RENDER_EXTENT_GRANULARITY
+        VkExtent2D renderExtent = {WINDOW_SIZE_WIDTH, WINDOW_SIZE_HEIGHT};
+        // Multiplier of the integration step
+        float stepScale = 1.0F;
+    };
+
+    // Zero target disables the governor and resets settings to the full quality
+    void SetTargetFrameTime(double milliseconds);
+    double GetTargetFrameTime() const;
+
+    // Measured GPU time of the last completed frame
+    void Update(double gpuMilliseconds);
+
+    Settings const& GetSettings() const;
+
+private:
+    void UpdateSettings();
+
+    double targetFrameTime = 0.0;
+    double smoothedFrameTime = 0.0;
+    double costScale = 1.0;
+    Settings settings{};
+};
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "my_vulkan/gpu_allocator.hpp"
+#include "utils/job_system.hpp"
 #include <functional>
 
 namespace KRV {
@@ -8,7 +9,9 @@ namespace KRV {
 class BasePass {
 public:
     virtual void AllocateResources(VkDevice device, Utils::GPUAllocator& gpuAllocator) = 0;
-    virtual void Init(VkDevice device) = 0;
+    // Pipelines are created through the pipeline cache, which is shared by all passes.
+    // Independent pipelines are compiled by jobs, they are ready when Init returns.
+    virtual void Init(VkDevice device, VkPipelineCache pipelineCache, JobSystem &jobSystem) = 0;
     virtual void Destroy(VkDevice device) = 0;
     virtual void RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer) = 0;
 };
@@ -0,0 +1,218 @@
+#include "black_hole_assets.hpp"
+
+#include "obj_transformation_matrices.hpp"
+#include "my_vulkan/vulkan_functions.hpp"
+#include "utils/mapped_file.hpp"
+
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+#include "third-party/stb_image.h"
+
+namespace {
+    // It is built from the faces by sky_converter
+    constexpr char const *cubeMapContainerFileName = "textures/black_hole/sky.ktx2";
+
+    static_assert(static_cast<VkFormat>(KRV::KTX2CubeMap::Format::BC6H_UFLOAT) == VK_FORMAT_BC6H_UFLOAT_BLOCK &&
+        static_cast<VkFormat>(KRV::KTX2CubeMap::Format::BC7_UNORM) == VK_FORMAT_BC7_UNORM_BLOCK);
+
+    constexpr char const *cubeMapsFaceNames[KRV::BlackHoleAssets::CUBE_MAP_FACES_NUM] = {
+        "textures/black_hole/left.png",
+        "textures/black_hole/right.png",
+        "textures/black_hole/bottom.png",
+        "textures/black_hole/top.png",
+        "textures/black_hole/back.png",
+        "textures/black_hole/front.png"
+    };
+
+    // Every object has its own `.obj` and `.png` files
+    constexpr uint32_t objectsNum = std::size(KRV::blasTransformMatrices);
+
+    std::string GetObjectFileName(uint32_t idx) {
+        return std::format("objects/obj{}.obj", idx);
+    }
+
+    std::string GetObjectTextureFileName(uint32_t idx) {
+        return std::format("textures/obj{}.png", idx);
+    }
+
+    // stb_image doesn't use global state for decoding, so files are decoded by several jobs at once.
+    // Compressed data are decoded straight from the mapped file without reading into a buffer.
+    void DecodeImage(char const *fileName, KRV::BlackHoleAssets::ImageData &imageData) {
+        KRV::MappedFile const file(fileName);
+        uint8_t *pixels = nullptr;
+        int x = 0, y = 0, channels = 0;
+        if (file.IsOpen()) {
+            pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &x, &y, &channels, STBI_rgb_alpha);
+        }
+
+        if (pixels == nullptr) {
+            throw std::runtime_error(std::format("[BlackHoleAssets] Cannot decode {}", fileName));
+        }
+
+        imageData.extent = {static_cast<uint32_t>(x), static_cast<uint32_t>(y)};
+        imageData.pixels = {pixels, stbi_image_free};
+    }
+
+    // Block compressed formats need the device feature, which is enabled whenever it is supported
+    bool IsCompressedFormatSampled(VkPhysicalDevice physicalDevice, VkFormat format) {
+        VkPhysicalDeviceFeatures supportedFeatures{};
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        if (supportedFeatures.textureCompressionBC != VK_TRUE) {
+            return false;
+        }
+
+        constexpr VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+        VkFormatProperties formatProperties{};
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+
+        return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+    }
+
+    VkExtent2D GetImageExtent(char const *fileName) {
+        int x = 0, y = 0;
+        if (stbi_info(fileName, &x, &y, nullptr) == 0) {
+            throw std::runtime_error(std::format("[BlackHoleAssets] Cannot read {}", fileName));
+        }
+
+        return {static_cast<uint32_t>(x), static_cast<uint32_t>(y)};
+    }
+}
+
+namespace KRV {
+
+void BlackHoleAssets::Load(JobSystem &jobSystem, VkPhysicalDevice physicalDevice, bool isRayQuerySupported) {
+    pJobSystem = &jobSystem;
+
+    // Only the header of the container is read here, levels are paged in by copies into the staging buffer
+    cubeMapContainer = std::make_unique<KTX2CubeMap>(cubeMapContainerFileName);
+    if (!cubeMapContainer->IsValid()) {
+        if (std::filesystem::exists(cubeMapContainerFileName)) {
+            std::cerr << std::format("[BlackHoleAssets] {} is broken, PNG faces are used\n", cubeMapContainerFileName);
+        }
+        cubeMapContainer.reset();
+    } else if (!IsCompressedFormatSampled(physicalDevice, static_cast<VkFormat>(cubeMapContainer->GetFormat()))) {
+        std::cout << std::format("[BlackHoleAssets] Format of {} is not supported, PNG faces are used\n", cubeMapContainerFileName);
+        cubeMapContainer.reset();
+    }
+
+    if (cubeMapContainer) {
+        cubeMapInfo = {
+            .format = static_cast<VkFormat>(cubeMapContainer->GetFormat()),
+            .extent = {cubeMapContainer->GetDimension(), cubeMapContainer->GetDimension()},
+            .levelsNum = cubeMapContainer->GetLevelsNum()
+        };
+    } else {
+        cubeMapInfo = {
+            .format = VK_FORMAT_R8G8B8A8_UNORM,
+            .extent = GetImageExtent(cubeMapsFaceNames[0]),
+            .levelsNum = 1U
+        };
+
+        for (uint32_t faceIdx = 0U; faceIdx < CUBE_MAP_FACES_NUM; faceIdx++) {
+            jobSystem.Submit(cubeMapGroups[faceIdx], [this, faceIdx](){
+                DecodeImage(cubeMapsFaceNames[faceIdx], cubeMapFaces[faceIdx]);
+            });
+        }
+    }
+
+    if (!isRayQuerySupported) {
+        return;
+    }
+
+    objects.resize(objectsNum);
+    objectTextures.resize(objectsNum);
+    for (uint32_t idx = 0U; idx < objectsNum; idx++) {
+        jobSystem.Submit(objectsGroup, [this, idx](){
+            objects[idx].Init(GetObjectFileName(idx));
+        });
+
+        jobSystem.Submit(objectTexturesGroup, [this, idx](){
+            DecodeImage(GetObjectTextureFileName(idx).c_str(), objectTextures[idx]);
+        });
+    }
+}
+
+void BlackHoleAssets::Wait() {
+    if (pJobSystem == nullptr) {
+        return;
+    }
+
+    // Jobs of other groups still write into assets, so they are waited before rethrowing
+    std::exception_ptr exception = nullptr;
+    auto const waitGroup = [this, &exception](JobSystem::Group &group){
+        std::exception_ptr const groupException = pJobSystem->WaitNoThrow(group);
+        if (!exception) {
+            exception = groupException;
+        }
+    };
+
+    for (auto &cubeMapGroup : cubeMapGroups) {
+        waitGroup(cubeMapGroup);
+    }
+    waitGroup(objectsGroup);
+    waitGroup(objectTexturesGroup);
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+BlackHoleAssets::CubeMapInfo BlackHoleAssets::GetCubeMapInfo() const {
+    return cubeMapInfo;
+}
+
+VkExtent2D BlackHoleAssets::GetObjectTextureExtent(uint32_t idx) const {
+    return GetImageExtent(GetObjectTextureFileName(idx).c_str());
+}
+
+bool BlackHoleAssets::IsCubeMapContainerUsed() const {
+    return cubeMapContainer != nullptr;
+}
+
+KTX2CubeMap::Level BlackHoleAssets::GetCubeMapLevel(uint32_t levelIdx) const {
+    return cubeMapContainer->GetLevel(levelIdx);
+}
+
+BlackHoleAssets::ImageData const & BlackHoleAssets::GetCubeMapFace(uint32_t faceIdx) {
+    pJobSystem->Wait(cubeMapGroups[faceIdx]);
+    return cubeMapFaces[faceIdx];
+}
+
+void BlackHoleAssets::ReleaseCubeMapFace(uint32_t faceIdx) {
+    pJobSystem->Wait(cubeMapGroups[faceIdx]);
+    cubeMapFaces[faceIdx].pixels.reset();
+}
+
+uint32_t BlackHoleAssets::GetObjectsNum() const {
+    return objectsNum;
+}
+
+OBJData const & BlackHoleAssets::GetObject(uint32_t idx) {
+    pJobSystem->Wait(objectsGroup);
+    return objects[idx];
+}
+
+BlackHoleAssets::ImageData const & BlackHoleAssets::GetObjectTexture(uint32_t idx) {
+    pJobSystem->Wait(objectTexturesGroup);
+    return objectTextures[idx];
+}
+
+void BlackHoleAssets::ReleaseImages() {
+    Wait();
+
+    cubeMapContainer.reset();
+    for (auto &face : cubeMapFaces) {
+        face.pixels.reset();
+    }
+    for (auto &texture : objectTextures) {
+        texture.pixels.reset();
+    }
+}
+
+}
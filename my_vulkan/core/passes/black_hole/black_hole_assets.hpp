@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include "utils/job_system.hpp"
+#include "utils/ktx2.hpp"
+#include "utils/obj_data.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace KRV {
+
+// Files of BlackHolePass: sky cube map faces, object meshes and their textures.
+// They are decoded by jobs as soon as the device is chosen, so decoding overlaps the rest of Vulkan initialization.
+// Getters wait only for the data, which they return. Exceptions of jobs are rethrown by waits.
+// The sky is taken from a block compressed container with mip levels, if it is built and the device samples its format.
+// Otherwise faces are decoded from PNG files into one RGBA8 level.
+class BlackHoleAssets final {
+public:
+    static constexpr uint32_t CUBE_MAP_FACES_NUM = 6U;
+
+    // Decoded RGBA8 image
+    struct ImageData final {
+        VkExtent2D extent = {};
+        std::unique_ptr<uint8_t, void(*)(void*)> pixels = {nullptr, nullptr};
+    };
+
+    struct CubeMapInfo final {
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+        VkExtent2D extent = {};
+        uint32_t levelsNum = 1U;
+    };
+
+    BlackHoleAssets() = default;
+
+    BlackHoleAssets(BlackHoleAssets const &) = delete;
+    BlackHoleAssets& operator=(BlackHoleAssets const &) = delete;
+    BlackHoleAssets(BlackHoleAssets &&) = delete;
+    BlackHoleAssets& operator=(BlackHoleAssets &&) = delete;
+
+    ~BlackHoleAssets() = default;
+
+    // Objects are used only by ray query. Physical device tells whether the compressed sky can be sampled.
+    void Load(JobSystem &jobSystem, VkPhysicalDevice physicalDevice, bool isRayQuerySupported);
+    // Wait for all jobs, e.g. before destruction. The first exception of jobs is rethrown after all of them are finished.
+    void Wait();
+
+    // Sizes are read from file headers, so they don't wait for decoding
+    CubeMapInfo GetCubeMapInfo() const;
+    VkExtent2D GetObjectTextureExtent(uint32_t idx) const;
+
+    // Levels of the mapped container are ready at once, they are copied from pages of the file
+    bool IsCubeMapContainerUsed() const;
+    KTX2CubeMap::Level GetCubeMapLevel(uint32_t levelIdx) const;
+    // Faces are waited one by one, so a face is consumed as soon as it is decoded
+    ImageData const & GetCubeMapFace(uint32_t faceIdx);
+    void ReleaseCubeMapFace(uint32_t faceIdx);
+    uint32_t GetObjectsNum() const;
+    OBJData const & GetObject(uint32_t idx);
+    ImageData const & GetObjectTexture(uint32_t idx);
+
+    // Pixels are freed and the container is unmapped after they are copied into staging buffers
+    void ReleaseImages();
+
+private:
+    JobSystem *pJobSystem = nullptr;
+
+    std::unique_ptr<KTX2CubeMap> cubeMapContainer{};
+    CubeMapInfo cubeMapInfo{};
+    std::array<ImageData, CUBE_MAP_FACES_NUM> cubeMapFaces{};
+    std::vector<OBJData> objects{};
+    std::vector<ImageData> objectTextures{};
+
+    std::array<JobSystem::Group, CUBE_MAP_FACES_NUM> cubeMapGroups{};
+    JobSystem::Group objectsGroup{};
+    JobSystem::Group objectTexturesGroup{};
+};
+
+}
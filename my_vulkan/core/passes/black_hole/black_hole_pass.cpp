@@ -8,27 +8,43 @@
 
 #include "common.hpp"
 
+#include <cstddef>
 #include <cstring>
+#include <algorithm>
 #include <cmath>
+#include <format>
+#include <stdexcept>
 #include <utility>
 
-#include "third-party/stb_image.h"
-
 namespace {
-    constexpr char const *cubeMapsFaceNames[6] = {
-        "textures/black_hole/left.png",
-        "textures/black_hole/right.png",
-        "textures/black_hole/bottom.png",
-        "textures/black_hole/top.png",
-        "textures/black_hole/back.png",
-        "textures/black_hole/front.png"
+    constexpr uint32_t cubeMapFacesNum = KRV::BlackHoleAssets::CUBE_MAP_FACES_NUM;
+
+    constexpr KRV::Utils::SHADER_LIST_ID renderModeShaders[KRV::RENDER_MODE_COUNT] = {
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK1_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK2_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK4_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_QUERY_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTED_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK45_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_ANALYTIC_COMP
     };
 
-    constexpr uint32_t cubeMapFacesNum = std::size(cubeMapsFaceNames);
+    static_assert(static_cast<uint32_t>(KRV::MARCHING_DISPATCH::GRID) == MARCHING_DISPATCH_GRID &&
+        static_cast<uint32_t>(KRV::MARCHING_DISPATCH::WAVEFRONT) == MARCHING_DISPATCH_WAVEFRONT &&
+        static_cast<uint32_t>(KRV::MARCHING_DISPATCH::PERSISTENT_THREADS) == MARCHING_DISPATCH_PERSISTENT_THREADS);
+
+    // Compacted dispatch of interleaved tracing covers half of the width and the height by 2x2 blocks
+    static_assert(KRV::WINDOW_SIZE_WIDTH % RENDER_EXTENT_GRANULARITY == 0U && KRV::WINDOW_SIZE_HEIGHT % RENDER_EXTENT_GRANULARITY == 0U);
 }
 
 namespace KRV {
 
+BlackHolePass::BlackHolePass(bool isRayQuerySupported, BlackHoleSpecialization const &specialization, BlackHoleAssets &assets)
+    : pAssets(&assets), isRayQuerySupported(isRayQuerySupported), specialization(specialization) {
+    marchingDispatches.fill(MARCHING_DISPATCH::WAVEFRONT);
+    modeSpecializations.fill(specialization);
+}
+
 void BlackHolePass::AllocateResources(VkDevice device, Utils::GPUAllocator& gpuAllocator) {
     Utils::CreateImageInfo createImageInfo {
         .extent = {
@@ -42,36 +58,62 @@ void BlackHolePass::AllocateResources(VkDevice device, Utils::GPUAllocator& gpuA
 
     pFinalImage = &gpuAllocator.AddImage(device, createImageInfo);
 
+    Utils::CreateImageInfo historyImageInfo {
+        .extent = createImageInfo.extent,
+        .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .name = "BlackHolePass::historyImage"
+    };
+
+    pHistoryImage = &gpuAllocator.AddImage(device, historyImageInfo);
+
+    Utils::CreateImageInfo accumulationImageInfo {
+        .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+        .extent = createImageInfo.extent,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT,
+        .name = "BlackHolePass::accumulationImage"
+    };
+
+    pAccumulationImage = &gpuAllocator.AddImage(device, accumulationImageInfo);
+
     AllocateCubeMap(device, gpuAllocator);
+    AllocateMarchingBuffers(device, gpuAllocator);
 
-#ifdef BLACK_HOLE_PRECOMPUTED
     pPrecomputedPhiTexture = &gpuAllocator.GetImage(PRECOMPUTED_PHI_TEXTURE_NAME);
     pPrecomputedAccrDiskDataTexture = &gpuAllocator.GetImage(PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_NAME);
-#endif // BLACK_HOLE_PRECOMPUTED
 
-#ifdef BLACK_HOLE_RAY_QUERY
-    AllocateBottomLevelASes(device, gpuAllocator, std::size(blasTransformMatrices));
-    AllocateTopLevelAS(device, gpuAllocator);
-#endif // BLACK_HOLE_RAY_QUERY
+    if (isRayQuerySupported) {
+        AllocateBottomLevelASes(device, gpuAllocator, std::size(blasTransformMatrices));
+        AllocateTopLevelAS(device, gpuAllocator);
+    }
 }
 
-void BlackHolePass::Init(VkDevice device) {
+void BlackHolePass::Init(VkDevice device, VkPipelineCache pipelineCache, JobSystem &jobSystem) {
+    this->pipelineCache = pipelineCache;
     InitSampler(device);
     InitDescriptorSet(device);
-    InitPipeline(device);
+    // Staging buffer is mapped since GPUAllocator::PresentResources, so the sky is copied while pipelines are compiled
+    StartCubeMapUpload(jobSystem);
+    InitPipeline(device, jobSystem);
 }
 
 void BlackHolePass::Destroy(VkDevice device) {
+    // Jobs write into the staging buffer, so they are finished before its memory is freed
+    if (pJobSystem != nullptr) {
+        pJobSystem->Wait(cubeMapUploadGroup);
+    }
 
-#ifdef BLACK_HOLE_RAY_QUERY
-    vkDestroyAccelerationStructureKHR(device, std::exchange(tlasInfo.tlas, VK_NULL_HANDLE), nullptr);
+    if (isRayQuerySupported) {
+        vkDestroyAccelerationStructureKHR(device, std::exchange(tlasInfo.tlas, VK_NULL_HANDLE), nullptr);
 
-    for (auto &blasInfo : blasInfos) {
-        vkDestroyAccelerationStructureKHR(device, std::exchange(blasInfo.blas, VK_NULL_HANDLE), nullptr);
+        for (auto &blasInfo : blasInfos) {
+            vkDestroyAccelerationStructureKHR(device, std::exchange(blasInfo.blas, VK_NULL_HANDLE), nullptr);
+        }
     }
-#endif // BLACK_HOLE_RAY_QUERY
 
-    vkDestroyPipeline(device, std::exchange(pipeline, VK_NULL_HANDLE), nullptr);
+    for (auto &pipeline : pipelines) {
+        vkDestroyPipeline(device, std::exchange(pipeline, VK_NULL_HANDLE), nullptr);
+    }
+    vkDestroyPipeline(device, std::exchange(reconstructPipeline, VK_NULL_HANDLE), nullptr);
     vkDestroyPipelineLayout(device, std::exchange(pipelineLayout, VK_NULL_HANDLE), nullptr);
     vkDestroyDescriptorSetLayout(device, std::exchange(descriptorSetLayout, VK_NULL_HANDLE), nullptr);
     vkDestroyDescriptorPool(device, std::exchange(descriptorPool, VK_NULL_HANDLE), nullptr);
@@ -82,56 +124,231 @@ void BlackHolePass::RecordCommandBuffer(VkDevice device, VkCommandBuffer command
     Utils::DebugUtils::LabelGuard labelGuard(commandBuffer, "BlackHolePass", 0.5F, 0.0F, 0.0F);
 
     if (isFirstRecording) {
-#ifdef BLACK_HOLE_RAY_QUERY
-        BuildBottomLevelASes(device, commandBuffer);
-        BuildTopLevelAS(device, commandBuffer);
-#endif // BLACK_HOLE_RAY_QUERY
-        LoadCubeMap(device, commandBuffer);
+        if (!isUploadRecorded) {
+            RecordUpload(device, commandBuffer, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+        }
+        RecordUploadOwnershipTransfer(commandBuffer, false);
+
+        if (isRayQuerySupported) {
+            BuildBottomLevelASes(device, commandBuffer);
+            BuildTopLevelAS(device, commandBuffer);
+        }
+        LoadCubeMap(commandBuffer);
         isFirstRecording = false;
     }
 
+    // Final image keeps the converged result, so there is nothing to dispatch
+    if (IsConverged(cameraPosition, cameraDirection)) {
+        return;
+    }
+
+    // Static camera accumulates refinement samples into the same image
+    bool const isStatic = isProgressiveRefinementEnabled && isPreviousFrameValid &&
+        cameraPosition == previousCameraPosition && cameraDirection == previousCameraDirection;
+    refinementSample = isStatic ? refinementSample + 1U : 0U;
+
     // Force to undefined image layout, because of performance
     pFinalImage->layout = VK_IMAGE_LAYOUT_UNDEFINED;
     Utils::ImagePipelineBarrier(commandBuffer, *pFinalImage, VK_IMAGE_LAYOUT_GENERAL,
         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
 
+    if (refinementSample > 0U) {
+        Utils::ImagePipelineBarrier(commandBuffer, *pAccumulationImage, VK_IMAGE_LAYOUT_GENERAL,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+
+    // Refined image is always rendered with full quality, the governor is ignored meanwhile
+    VkExtent2D const previousFrameExtent = frameExtent;
+    frameExtent = (refinementSample > 0U) ? VkExtent2D{WINDOW_SIZE_WIDTH, WINDOW_SIZE_HEIGHT} : renderExtent;
+    float const frameStepScale = (refinementSample > 0U) ? 1.0F : stepScale;
+
+    // Every pixel is traced, if there is nothing to reproject from or the image is refined
+    uint32_t const factor = (refinementSample == 0U && IsHistoryUsable()) ? interleaveFactor : 1U;
+    // Other modes have no steps, so every pixel costs the same
+    MARCHING_DISPATCH const marchingDispatch = IsRayMarchingMode(renderMode) ?
+        marchingDispatches[static_cast<uint32_t>(renderMode)] : MARCHING_DISPATCH::GRID;
+    uint32_t const frameInfo = (factor << FRAME_INFO_INTERLEAVE_FACTOR_SHIFT) |
+        ((interleavePhase % factor) << FRAME_INFO_INTERLEAVE_PHASE_SHIFT) |
+        (refinementSample << FRAME_INFO_REFINEMENT_SAMPLE_SHIFT);
+
     // Update Push Constants
-    camera.Update();
-    auto const &position = camera.GetPosition();
-    auto const &direction = camera.GetDirection();
 
 #pragma pack(push, 1)
     struct PushConst final {
         glm::vec3 cameraPos;
-        float placeholder1 = 0.0F;
+        uint32_t frameInfo;
         glm::vec3 cameraDir;
-#ifdef BLACK_HOLE_RAY_QUERY
-        float placeholder2 = 0.0F;
-        VkDeviceAddress texCoordsDeviceAddress[NUM_OF_BLAS_TEXTURES];
-        VkDeviceAddress texCoordIndicesDeviceAddress[NUM_OF_BLAS_TEXTURES];
-#endif // BLACK_HOLE_RAY_QUERY
+        float rk45Tolerance;
+        VkExtent2D renderExtent;
+        float stepScale;
+        uint32_t marchingDispatch;
+        uint32_t wavefrontPass;
     } pushConst {
-        .cameraPos = position,
-        .cameraDir = direction,
+        .cameraPos = cameraPosition,
+        .frameInfo = frameInfo,
+        .cameraDir = cameraDirection,
+        .rk45Tolerance = rk45Tolerance,
+        .renderExtent = frameExtent,
+        .stepScale = frameStepScale,
+        .marchingDispatch = static_cast<uint32_t>(marchingDispatch),
+        .wavefrontPass = 0U
     };
 #pragma pack(pop)
 
-#ifdef BLACK_HOLE_RAY_QUERY
-    std::memcpy(pushConst.texCoordsDeviceAddress, texCoordsDeviceAddress.data(),
-        texCoordsDeviceAddress.size()*sizeof(VkDeviceAddress));
-    std::memcpy(pushConst.texCoordIndicesDeviceAddress, texCoordIndicesDeviceAddress.data(),
-        texCoordIndicesDeviceAddress.size()*sizeof(VkDeviceAddress));
-#endif // BLACK_HOLE_RAY_QUERY
+    if (marchingDispatch == MARCHING_DISPATCH::WAVEFRONT) {
+        ResetWavefrontQueues(commandBuffer);
+    } else if (marchingDispatch == MARCHING_DISPATCH::PERSISTENT_THREADS) {
+        ResetPersistentThreadsWorkCounter(commandBuffer);
+    }
 
     vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
         0U, sizeof(PushConst), &pushConst);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[static_cast<uint32_t>(renderMode)]);
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0U, 1U, &descriptorSet, 0U, nullptr);
-    vkCmdDispatch(commandBuffer, WINDOW_SIZE_WIDTH/LOCAL_SIZE_X, WINDOW_SIZE_HEIGHT/LOCAL_SIZE_Y, 1U);
+    // Only traced pixels are dispatched: checkerboard halves the width, 2x2 blocks halve both dimensions
+    BlackHoleSpecialization const &modeSpecialization = modeSpecializations[static_cast<uint32_t>(renderMode)];
+    uint32_t const groupCountX = modeSpecialization.GetGroupCountX(frameExtent.width/(factor > 1U ? 2U : 1U));
+    uint32_t const groupCountY = modeSpecialization.GetGroupCountY(frameExtent.height/(factor > 2U ? 2U : 1U));
+    if (marchingDispatch == MARCHING_DISPATCH::PERSISTENT_THREADS) {
+        // Workgroups fetch pixels themselves, so only enough of them to fill the device are launched
+        vkCmdDispatch(commandBuffer, std::min(groupCountX*groupCountY, PERSISTENT_THREADS_WORKGROUP_COUNT), 1U, 1U);
+    } else {
+        vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1U);
+    }
+
+    if (marchingDispatch == MARCHING_DISPATCH::WAVEFRONT) {
+        RecordWavefrontPasses(commandBuffer, offsetof(PushConst, wavefrontPass));
+    }
+
+    if (factor > 1U) {
+        RecordReconstruction(commandBuffer, frameInfo, previousFrameExtent);
+    }
 
     Utils::ImagePipelineBarrier(commandBuffer, *pFinalImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    // History is kept only while interleaving is on
+    isHistoryValid = (interleaveFactor > 1U);
+    if (isHistoryValid) {
+        RecordHistoryCopy(commandBuffer);
+    }
+    interleavePhase = (interleavePhase + 1U) % interleaveFactor;
+
+    isPreviousFrameValid = true;
+    previousCameraPosition = cameraPosition;
+    previousCameraDirection = cameraDirection;
+}
+
+bool BlackHolePass::IsConverged(glm::vec3 const &position, glm::vec3 const &direction) const {
+    return isPreviousFrameValid && refinementSample >= REFINEMENT_SAMPLE_COUNT &&
+        position == previousCameraPosition && direction == previousCameraDirection;
+}
+
+void BlackHolePass::ResetWavefrontQueues(VkCommandBuffer commandBuffer) {
+    // Every pass counts its rays from zero, dispatch size is (0, 1, 1) until rays are appended
+    std::array<glm::uvec4, WAVEFRONT_PASS_COUNT> queueHeaders{};
+    queueHeaders.fill(glm::uvec4(0U, 1U, 1U, 0U));
+
+    // Previous frame may still read queues by indirect dispatches
+    Utils::MemoryPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    vkCmdUpdateBuffer(commandBuffer, pWavefrontRayQueuesBuffer->buffer, 0ULL, sizeof(queueHeaders), queueHeaders.data());
+
+    Utils::MemoryPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void BlackHolePass::ResetPersistentThreadsWorkCounter(VkCommandBuffer commandBuffer) {
+    // Previous frame may still fetch pixels
+    Utils::MemoryPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    vkCmdFillBuffer(commandBuffer, pPersistentThreadsWorkCounterBuffer->buffer, 0ULL, VK_WHOLE_SIZE, 0U);
+
+    Utils::MemoryPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void BlackHolePass::RecordWavefrontPasses(VkCommandBuffer commandBuffer, uint32_t wavefrontPassOffset) {
+    Utils::DebugUtils::LabelGuard labelGuard(commandBuffer, "WavefrontPasses", 0.5F, 0.0F, 0.5F);
+
+    for (uint32_t pass = 1U; pass < WAVEFRONT_PASS_COUNT; pass++) {
+        // Queue of the previous pass is complete, its header is the dispatch size of this pass
+        Utils::MemoryPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+            wavefrontPassOffset, sizeof(pass), &pass);
+        vkCmdDispatchIndirect(commandBuffer, pWavefrontRayQueuesBuffer->buffer, (pass - 1U)*sizeof(glm::uvec4));
+    }
+}
+
+bool BlackHolePass::IsHistoryUsable() const {
+    // Ray query scene isn't at infinity, so reprojection of its translation is wrong
+    return isHistoryValid && (renderMode != RENDER_MODE::RAY_QUERY || cameraPosition == previousCameraPosition);
+}
+
+void BlackHolePass::RecordReconstruction(VkCommandBuffer commandBuffer, uint32_t frameInfo, VkExtent2D previousFrameExtent) {
+    Utils::DebugUtils::LabelGuard labelGuard(commandBuffer, "Reconstruction", 0.5F, 0.5F, 0.0F);
+
+    // Traced pixels are read as neighbours of reconstructed ones
+    Utils::ImagePipelineBarrier(commandBuffer, *pFinalImage, VK_IMAGE_LAYOUT_GENERAL,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    Utils::ImagePipelineBarrier(commandBuffer, *pHistoryImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+#pragma pack(push, 1)
+    struct PushConst final {
+        glm::vec3 cameraPos;
+        uint32_t frameInfo;
+        glm::vec3 cameraDir;
+        float placeholder1 = 0.0F;
+        VkExtent2D renderExtent;
+        VkExtent2D previousRenderExtent;
+        glm::vec3 previousCameraPos;
+        float placeholder2 = 0.0F;
+        glm::vec3 previousCameraDir;
+    } pushConst {
+        .cameraPos = cameraPosition,
+        .frameInfo = frameInfo,
+        .cameraDir = cameraDirection,
+        .renderExtent = frameExtent,
+        .previousRenderExtent = previousFrameExtent,
+        .previousCameraPos = previousCameraPosition,
+        .previousCameraDir = previousCameraDirection
+    };
+#pragma pack(pop)
+
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
+        0U, sizeof(PushConst), &pushConst);
+
+    // Descriptor set is shared with render mode pipelines, so it stays bound
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reconstructPipeline);
+    vkCmdDispatch(commandBuffer, specialization.GetGroupCountX(frameExtent.width), specialization.GetGroupCountY(frameExtent.height), 1U);
+}
+
+void BlackHolePass::RecordHistoryCopy(VkCommandBuffer commandBuffer) {
+    Utils::ImagePipelineBarrier(commandBuffer, *pHistoryImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkImageCopy region {
+        .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 0U, 1U},
+        .srcOffset = {0, 0, 0},
+        .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 0U, 1U},
+        .dstOffset = {0, 0, 0},
+        .extent = {frameExtent.width, frameExtent.height, 1U}
+    };
+
+    vkCmdCopyImage(commandBuffer, pFinalImage->image, pFinalImage->layout,
+        pHistoryImage->image, pHistoryImage->layout, 1U, &region);
 }
 
 void BlackHolePass::InitSampler(VkDevice device) {
@@ -141,7 +358,7 @@ void BlackHolePass::InitSampler(VkDevice device) {
         .flags = 0U,
         .magFilter = VK_FILTER_LINEAR,
         .minFilter = VK_FILTER_LINEAR,
-        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
         .addressModeU = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT,
         .addressModeV = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT,
         .addressModeW = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT,
@@ -151,7 +368,8 @@ void BlackHolePass::InitSampler(VkDevice device) {
         .compareEnable = VK_FALSE,
         .compareOp = VK_COMPARE_OP_NEVER,
         .minLod = 0.0F,
-        .maxLod = 0.0F,
+        // Shaders pick levels by footprints of rays, tables have a single level
+        .maxLod = VK_LOD_CLAMP_NONE,
         .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
         .unnormalizedCoordinates = VK_FALSE
     };
@@ -162,63 +380,49 @@ void BlackHolePass::InitSampler(VkDevice device) {
 }
 
 void BlackHolePass::InitDescriptorSet(VkDevice device) {
-    VkDescriptorPoolSize descriptorPoolSizes[] = {
+    // Descriptors for all render modes live in one descriptor set, every pipeline uses only its own bindings.
+    std::vector<VkDescriptorPoolSize> descriptorPoolSizes = {
         {
             .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-#if defined(BLACK_HOLE_PRECOMPUTED)
-            .descriptorCount = 3U
-#elif defined(BLACK_HOLE_RAY_QUERY)
-            .descriptorCount = 1U + NUM_OF_BLAS_TEXTURES
-#else
-            .descriptorCount = 1U
-#endif // BLACK_HOLE_PRECOMPUTED
+            .descriptorCount = (isRayQuerySupported ? 4U + NUM_OF_BLAS_TEXTURES : 4U)
         },
-#ifdef BLACK_HOLE_RAY_QUERY
         {
-            .type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
-            .descriptorCount = 1U
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 2U
         },
-#endif // BLACK_HOLE_RAY_QUERY
         {
-            .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-            .descriptorCount = 1U
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 3U
         }
     };
 
+    if (isRayQuerySupported) {
+        descriptorPoolSizes.push_back(VkDescriptorPoolSize{
+            .type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
+            .descriptorCount = 1U
+        });
+        descriptorPoolSizes.push_back(VkDescriptorPoolSize{
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U
+        });
+    }
+
     VkDescriptorPoolCreateInfo descriptorPoolCI {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0U,
         .maxSets = 1U,
-        .poolSizeCount = std::size(descriptorPoolSizes),
-        .pPoolSizes = descriptorPoolSizes
+        .poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size()),
+        .pPoolSizes = descriptorPoolSizes.data()
     };
 
     VK_CALL(vkCreateDescriptorPool(device, &descriptorPoolCI, nullptr, &descriptorPool));
 
     Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_DESCRIPTOR_POOL, descriptorPool, "BlackHolePass::DescriptorPool");
 
-#ifdef BLACK_HOLE_RAY_QUERY
     std::vector<VkSampler> linearSamplers(NUM_OF_BLAS_TEXTURES, sampler);
-#endif // BLACK_HOLE_RAY_QUERY
 
-    VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[] = {
-#ifdef BLACK_HOLE_RAY_QUERY
-        {
-            .binding = BINDING_RAY_QUERY_TEXTURES,
-            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-            .descriptorCount = NUM_OF_BLAS_TEXTURES,
-            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-            .pImmutableSamplers = linearSamplers.data()
-        },
-        {
-            .binding = BINDING_RAY_QUERY_TLAS,
-            .descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
-            .descriptorCount = 1U,
-            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
-            .pImmutableSamplers = nullptr
-        },
-#endif // BLACK_HOLE_RAY_QUERY
+    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings = {
         {
             .binding = BINDING_FINAL_IMAGE,
             .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
@@ -232,9 +436,8 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .descriptorCount = 1U,
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
             .pImmutableSamplers = &sampler
-        }
-#ifdef BLACK_HOLE_PRECOMPUTED
-        ,{
+        },
+        {
             .binding = BINDING_PRECOMPUTED_PHI_TEXTURE,
             .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
             .descriptorCount = 1U,
@@ -247,32 +450,89 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .descriptorCount = 1U,
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
             .pImmutableSamplers = &sampler
+        },
+        {
+            .binding = BINDING_HISTORY_IMAGE,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = &sampler
+        },
+        {
+            .binding = BINDING_ACCUMULATION_IMAGE,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = BINDING_WAVEFRONT_RAY_STATES,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = BINDING_WAVEFRONT_RAY_QUEUES,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = BINDING_PERSISTENT_THREADS_WORK_COUNTER,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
         }
-#endif // BLACK_HOLE_PRECOMPUTED
     };
 
-#ifdef BLACK_HOLE_RAY_QUERY
-    VkDescriptorBindingFlags bindingFlags[std::size(descriptorSetLayoutBindings)] = {};
-    bindingFlags[0] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    std::vector<VkDescriptorBindingFlags> bindingFlags(descriptorSetLayoutBindings.size(), 0U);
+
+    if (isRayQuerySupported) {
+        descriptorSetLayoutBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = BINDING_RAY_QUERY_TEXTURES,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = NUM_OF_BLAS_TEXTURES,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = linearSamplers.data()
+        });
+        bindingFlags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
 
+        descriptorSetLayoutBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = BINDING_RAY_QUERY_TLAS,
+            .descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        });
+        bindingFlags.push_back(0U);
+
+        descriptorSetLayoutBindings.push_back(VkDescriptorSetLayoutBinding{
+            .binding = BINDING_RAY_QUERY_BLAS_ADDRESSES,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
+        });
+        bindingFlags.push_back(0U);
+    }
+
+    // Binding flags require Vulkan 1.2 descriptor indexing, which is enabled only with ray query.
     VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCI {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
         .pNext = nullptr,
-        .bindingCount = std::size(bindingFlags),
-        .pBindingFlags = bindingFlags
+        .bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+        .pBindingFlags = bindingFlags.data()
     };
-#endif // BLACK_HOLE_RAY_QUERY
 
     VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-#ifdef BLACK_HOLE_RAY_QUERY
-        .pNext = &bindingFlagsCI,
-#else
-        .pNext = nullptr,
-#endif // BLACK_HOLE_RAY_QUERY
+        .pNext = (isRayQuerySupported ? &bindingFlagsCI : nullptr),
         .flags = 0U,
-        .bindingCount = std::size(descriptorSetLayoutBindings),
-        .pBindings = descriptorSetLayoutBindings
+        .bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings.size()),
+        .pBindings = descriptorSetLayoutBindings.data()
     };
 
     VK_CALL(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, nullptr, &descriptorSetLayout))
@@ -303,10 +563,9 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .sampler = VK_NULL_HANDLE,
             .imageView = pCubeMap->imageView,
             .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        }
-#ifdef BLACK_HOLE_PRECOMPUTED
+        },
         // Precomputed Phi Texture
-        ,{
+        {
             .sampler = VK_NULL_HANDLE,
             .imageView = pPrecomputedPhiTexture->imageView,
             .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
@@ -316,29 +575,40 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .sampler = VK_NULL_HANDLE,
             .imageView = pPrecomputedAccrDiskDataTexture->imageView,
             .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        },
+        // History Image
+        {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = pHistoryImage->imageView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        },
+        // Accumulation Image
+        {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = pAccumulationImage->imageView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL
         }
-#endif // BLACK_HOLE_PRECOMPUTED
     };
 
-#ifdef BLACK_HOLE_RAY_QUERY
-    VkWriteDescriptorSetAccelerationStructureKHR tlasWriteDescriptor {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
-        .pNext = nullptr,
-        .accelerationStructureCount = 1U,
-        .pAccelerationStructures = &tlasInfo.tlas
+    VkDescriptorBufferInfo marchingDescriptorBufferInfo[] = {
+        {
+            .buffer = pWavefrontRayStatesBuffer->buffer,
+            .offset = 0ULL,
+            .range = VK_WHOLE_SIZE
+        },
+        {
+            .buffer = pWavefrontRayQueuesBuffer->buffer,
+            .offset = 0ULL,
+            .range = VK_WHOLE_SIZE
+        },
+        {
+            .buffer = pPersistentThreadsWorkCounterBuffer->buffer,
+            .offset = 0ULL,
+            .range = VK_WHOLE_SIZE
+        }
     };
 
-    std::vector<VkDescriptorImageInfo> blasTexturesDescriptorImageInfos{};
-    for (uint32_t i = 0U; i < blasInfos.size(); i++) {
-        blasTexturesDescriptorImageInfos.push_back(VkDescriptorImageInfo{
-            .sampler = VK_NULL_HANDLE,
-            .imageView = blasInfos[i].pTexture->imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        });
-    }
-#endif // BLACK_HOLE_RAY_QUERY
-
-    VkWriteDescriptorSet writeDescriptors[] = {
+    std::vector<VkWriteDescriptorSet> writeDescriptors = {
         // Final Image
         {
             .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -364,10 +634,9 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .pImageInfo = &descriptorImageInfo[1],
             .pBufferInfo = nullptr,
             .pTexelBufferView = nullptr
-        }
-#ifdef BLACK_HOLE_PRECOMPUTED
+        },
         // Precomputed Phi Texture
-        ,{
+        {
             .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             .pNext = nullptr,
             .dstSet = descriptorSet,
@@ -391,11 +660,100 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .pImageInfo = &descriptorImageInfo[3],
             .pBufferInfo = nullptr,
             .pTexelBufferView = nullptr
+        },
+        // History Image
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_HISTORY_IMAGE,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &descriptorImageInfo[4],
+            .pBufferInfo = nullptr,
+            .pTexelBufferView = nullptr
+        },
+        // Accumulation Image
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_ACCUMULATION_IMAGE,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo = &descriptorImageInfo[5],
+            .pBufferInfo = nullptr,
+            .pTexelBufferView = nullptr
+        },
+        // States of Wavefront Rays
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_WAVEFRONT_RAY_STATES,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &marchingDescriptorBufferInfo[0],
+            .pTexelBufferView = nullptr
+        },
+        // Queues of Wavefront Rays
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_WAVEFRONT_RAY_QUEUES,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &marchingDescriptorBufferInfo[1],
+            .pTexelBufferView = nullptr
+        },
+        // Work Counter of Persistent Threads
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_PERSISTENT_THREADS_WORK_COUNTER,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &marchingDescriptorBufferInfo[2],
+            .pTexelBufferView = nullptr
+        }
+    };
+
+    VkWriteDescriptorSetAccelerationStructureKHR tlasWriteDescriptor {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR,
+        .pNext = nullptr,
+        .accelerationStructureCount = 1U,
+        .pAccelerationStructures = &tlasInfo.tlas
+    };
+
+    std::vector<VkDescriptorImageInfo> blasTexturesDescriptorImageInfos{};
+
+    VkDescriptorBufferInfo blasAddressesDescriptorBufferInfo {
+        .buffer = (isRayQuerySupported ? pBlasAddressesBuffer->buffer : VK_NULL_HANDLE),
+        .offset = 0ULL,
+        .range = VK_WHOLE_SIZE
+    };
+
+    if (isRayQuerySupported) {
+        for (uint32_t i = 0U; i < blasInfos.size(); i++) {
+            blasTexturesDescriptorImageInfos.push_back(VkDescriptorImageInfo{
+                .sampler = VK_NULL_HANDLE,
+                .imageView = blasInfos[i].pTexture->imageView,
+                .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            });
         }
-#endif // BLACK_HOLE_PRECOMPUTED
-#ifdef BLACK_HOLE_RAY_QUERY
+
         // Top Level Acceleration Structure
-        ,{
+        writeDescriptors.push_back(VkWriteDescriptorSet{
             .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
             .pNext = &tlasWriteDescriptor,
             .dstSet = descriptorSet,
@@ -406,11 +764,12 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .pImageInfo = nullptr,
             .pBufferInfo = nullptr,
             .pTexelBufferView = nullptr
-        },
+        });
+
         // Bottom Level Acceleration Structure Texture
-        {
+        writeDescriptors.push_back(VkWriteDescriptorSet{
             .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .pNext = &tlasWriteDescriptor,
+            .pNext = nullptr,
             .dstSet = descriptorSet,
             .dstBinding = BINDING_RAY_QUERY_TEXTURES,
             .dstArrayElement = 0U,
@@ -419,23 +778,33 @@ void BlackHolePass::InitDescriptorSet(VkDevice device) {
             .pImageInfo = blasTexturesDescriptorImageInfos.data(),
             .pBufferInfo = nullptr,
             .pTexelBufferView = nullptr
-        }
-#endif // BLACK_HOLE_RAY_QUERY
-    };
+        });
 
-    vkUpdateDescriptorSets(device, std::size(writeDescriptors), writeDescriptors, 0U, nullptr);
+        // Addresses of Bottom Level Acceleration Structure Buffers
+        writeDescriptors.push_back(VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_RAY_QUERY_BLAS_ADDRESSES,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &blasAddressesDescriptorBufferInfo,
+            .pTexelBufferView = nullptr
+        });
+    }
+
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writeDescriptors.size()), writeDescriptors.data(), 0U, nullptr);
 }
 
-void BlackHolePass::InitPipeline(VkDevice device) {
+void BlackHolePass::InitPipeline(VkDevice device, JobSystem &jobSystem) {
+    // Pipelines read different parts of the same range
     VkPushConstantRange pushConstantRanges[] = {
         {
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
             .offset = 0U,
-#ifdef BLACK_HOLE_RAY_QUERY
             .size = 128U
-#else
-            .size = 28U
-#endif // BLACK_HOLE_RAY_QUERY
         }
     };
 
@@ -453,17 +822,31 @@ void BlackHolePass::InitPipeline(VkDevice device) {
 
     Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout, "BlackHolePass::PipelineLayout");
 
-#ifdef BLACK_HOLE_PRECOMPUTED
-    Utils::ShaderModule blackHoleComp = Utils::ShaderModule(device, Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTED_COMP);
-#elif defined(BLACK_HOLE_RAY_QUERY)
-    Utils::ShaderModule blackHoleComp = Utils::ShaderModule(device, Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_QUERY_COMP);
-#elif defined(BLACK_HOLE_RAY_MARCHING_RK1)
-    Utils::ShaderModule blackHoleComp = Utils::ShaderModule(device, Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK1_COMP);
-#elif defined(BLACK_HOLE_RAY_MARCHING_RK2)
-    Utils::ShaderModule blackHoleComp = Utils::ShaderModule(device, Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK2_COMP);
-#else // defined(BLACK_HOLE_RAY_MARCHING_RK4)
-    Utils::ShaderModule blackHoleComp = Utils::ShaderModule(device, Utils::SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK4_COMP);
-#endif
+    // All pipelines are created at once, so switching of render mode doesn't cause any stalls.
+    // Their compilation is independent, so every pipeline is created by its own job.
+    JobSystem::Group pipelinesGroup{};
+    for (uint32_t modeIdx = 0U; modeIdx < RENDER_MODE_COUNT; modeIdx++) {
+        RENDER_MODE const mode = static_cast<RENDER_MODE>(modeIdx);
+        if (mode == RENDER_MODE::RAY_QUERY && !isRayQuerySupported) {
+            continue;
+        }
+
+        jobSystem.Submit(pipelinesGroup, [this, device, mode](){
+            InitRenderModePipeline(device, mode);
+        });
+    }
+
+    jobSystem.Submit(pipelinesGroup, [this, device](){
+        InitReconstructPipeline(device);
+    });
+
+    jobSystem.Wait(pipelinesGroup);
+}
+
+void BlackHolePass::InitRenderModePipeline(VkDevice device, RENDER_MODE mode) {
+    uint32_t const modeIdx = static_cast<uint32_t>(mode);
+    Utils::ShaderModule blackHoleComp = Utils::ShaderModule(device, renderModeShaders[modeIdx]);
+    VkSpecializationInfo const specializationInfo = modeSpecializations[modeIdx].GetInfo();
 
     VkPipelineShaderStageCreateInfo stageCI {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -472,7 +855,37 @@ void BlackHolePass::InitPipeline(VkDevice device) {
         .stage = VK_SHADER_STAGE_COMPUTE_BIT,
         .module = blackHoleComp,
         .pName = "main",
-        .pSpecializationInfo = nullptr
+        .pSpecializationInfo = &specializationInfo
+    };
+
+    VkComputePipelineCreateInfo pipelineCI {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0U,
+        .stage = stageCI,
+        .layout = pipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = 0U
+    };
+
+    VK_CALL(vkCreateComputePipelines(device, pipelineCache, 1U, &pipelineCI, nullptr, &pipelines[modeIdx]));
+
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE, pipelines[modeIdx],
+        std::format("BlackHolePass::Pipeline [{}]", GetRenderModeName(mode)).c_str());
+}
+
+void BlackHolePass::InitReconstructPipeline(VkDevice device) {
+    Utils::ShaderModule reconstructComp = Utils::ShaderModule(device, Utils::SHADER_LIST_ID::BLACK_HOLE_RECONSTRUCT_COMP);
+    VkSpecializationInfo const specializationInfo = specialization.GetInfo();
+
+    VkPipelineShaderStageCreateInfo stageCI {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0U,
+        .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+        .module = reconstructComp,
+        .pName = "main",
+        .pSpecializationInfo = &specializationInfo
     };
 
     VkComputePipelineCreateInfo pipelineCI {
@@ -485,89 +898,256 @@ void BlackHolePass::InitPipeline(VkDevice device) {
         .basePipelineIndex = 0U
     };
 
-    VK_CALL(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1U, &pipelineCI, nullptr, &pipeline));
+    VK_CALL(vkCreateComputePipelines(device, pipelineCache, 1U, &pipelineCI, nullptr, &reconstructPipeline));
 
-    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE, pipeline, "BlackHolePass::Pipeline");
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE, reconstructPipeline, "BlackHolePass::ReconstructPipeline");
 }
 
 Image& BlackHolePass::GetFinalImage() {
     return *pFinalImage;
 }
 
+void BlackHolePass::SetRenderMode(RENDER_MODE renderMode) {
+    if (this->renderMode != renderMode) {
+        isHistoryValid = false;
+        isPreviousFrameValid = false;
+    }
+    this->renderMode = renderMode;
+}
+
+void BlackHolePass::SetRK45Tolerance(float tolerance) {
+    if (rk45Tolerance != tolerance) {
+        isHistoryValid = false;
+        isPreviousFrameValid = false;
+    }
+    rk45Tolerance = tolerance;
+}
+
+void BlackHolePass::SetCameraPose(glm::vec3 const &position, glm::vec3 const &direction) {
+    cameraPosition = position;
+    cameraDirection = direction;
+}
+
+void BlackHolePass::SetProgressiveRefinement(bool isEnabled) {
+    isProgressiveRefinementEnabled = isEnabled;
+    isPreviousFrameValid = false;
+}
+
+void BlackHolePass::SetFrameSettings(VkExtent2D renderExtent, float stepScale) {
+    this->renderExtent = renderExtent;
+    this->stepScale = stepScale;
+}
+
+VkExtent2D BlackHolePass::GetRenderExtent() const {
+    return frameExtent;
+}
+
+void BlackHolePass::SetMarchingDispatch(RENDER_MODE renderMode, MARCHING_DISPATCH marchingDispatch) {
+    // All dispatches march rays identically, so refinement samples stay valid
+    marchingDispatches[static_cast<uint32_t>(renderMode)] = marchingDispatch;
+}
+
+MARCHING_DISPATCH BlackHolePass::GetMarchingDispatch(RENDER_MODE renderMode) const {
+    return marchingDispatches[static_cast<uint32_t>(renderMode)];
+}
+
+void BlackHolePass::SetWorkgroupSize(VkDevice device, RENDER_MODE renderMode, VkExtent2D workgroupSize) {
+    uint32_t const modeIdx = static_cast<uint32_t>(renderMode);
+    BlackHoleSpecialization &modeSpecialization = modeSpecializations[modeIdx];
+    if (modeSpecialization.localSizeX == workgroupSize.width && modeSpecialization.localSizeY == workgroupSize.height) {
+        return;
+    }
+
+    modeSpecialization.localSizeX = workgroupSize.width;
+    modeSpecialization.localSizeY = workgroupSize.height;
+
+    vkDestroyPipeline(device, std::exchange(pipelines[modeIdx], VK_NULL_HANDLE), nullptr);
+    InitRenderModePipeline(device, renderMode);
+}
+
+VkExtent2D BlackHolePass::GetWorkgroupSize(RENDER_MODE renderMode) const {
+    BlackHoleSpecialization const &modeSpecialization = modeSpecializations[static_cast<uint32_t>(renderMode)];
+    return {modeSpecialization.localSizeX, modeSpecialization.localSizeY};
+}
+
+bool BlackHolePass::IsRefining() const {
+    return refinementSample > 0U;
+}
+
+void BlackHolePass::SetInterleaveFactor(uint32_t factor) {
+    interleaveFactor = factor;
+    interleavePhase = 0U;
+}
+
+void BlackHolePass::RecordUpload(VkDevice device, VkCommandBuffer commandBuffer, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) {
+    Utils::DebugUtils::LabelGuard uploadGuard(commandBuffer, "BlackHolePass::Upload", 0.0F, 1.0F, 0.0F);
+
+    CopyCubeMap(commandBuffer);
+    if (isRayQuerySupported) {
+        CopyBottomLevelASData(device, commandBuffer);
+    }
+    // All pixels are in staging buffers already
+    pAssets->ReleaseImages();
+
+    isUploadRecorded = true;
+    uploadSrcQueueFamilyIndex = srcQueueFamilyIndex;
+    uploadDstQueueFamilyIndex = dstQueueFamilyIndex;
+    if (srcQueueFamilyIndex != dstQueueFamilyIndex) {
+        RecordUploadOwnershipTransfer(commandBuffer, true);
+    }
+}
+
+void BlackHolePass::RecordUploadOwnershipTransfer(VkCommandBuffer commandBuffer, bool isRelease) {
+    // Images keep the transfer layout, so the barriers don't depend on the way their mip chains are filled.
+    // Destination of the release barrier is ignored, it is given by the acquire one.
+    VkImageMemoryBarrier imageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = isRelease ? 0U : (VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT),
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = uploadSrcQueueFamilyIndex,
+        .dstQueueFamilyIndex = uploadDstQueueFamilyIndex,
+        .image = pCubeMap->image,
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, cubeMapLevelsNum, 0U, cubeMapFacesNum}
+    };
+
+    VkBufferMemoryBarrier bufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = isRelease ? 0U : VK_ACCESS_SHADER_READ_BIT,
+        .srcQueueFamilyIndex = uploadSrcQueueFamilyIndex,
+        .dstQueueFamilyIndex = uploadDstQueueFamilyIndex,
+        .buffer = VK_NULL_HANDLE,
+        .offset = 0ULL,
+        .size = VK_WHOLE_SIZE
+    };
+
+    std::vector<VkImageMemoryBarrier> imageMemoryBarriers = {imageMemoryBarrier};
+    std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers{};
+    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    if (isRayQuerySupported) {
+        for (auto const &blasInfo : blasInfos) {
+            for (Buffer const *pBuffer : {blasInfo.pVertexBuffer, blasInfo.pIndexBuffer, blasInfo.pTexCoordsBuffer, blasInfo.pTexCoordIndicesBuffer}) {
+                bufferMemoryBarrier.buffer = pBuffer->buffer;
+                bufferMemoryBarriers.push_back(bufferMemoryBarrier);
+            }
+
+            imageMemoryBarrier.image = blasInfo.pTexture->image;
+            imageMemoryBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, blasInfo.textureLevelsNum, 0U, 1U};
+            imageMemoryBarriers.push_back(imageMemoryBarrier);
+        }
+
+        // Geometry is read by builds of acceleration structures and by shaders
+        dstStage |= VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+
+    // Source stage of the acquire barrier is the one, which waits for the upload semaphore
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, isRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : dstStage, 0U,
+        0U, nullptr,
+        static_cast<uint32_t>(bufferMemoryBarriers.size()), bufferMemoryBarriers.data(),
+        static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data());
+}
+
 void BlackHolePass::AllocateCubeMap(VkDevice device, Utils::GPUAllocator& gpuAllocator) {
-    int isize_x, isize_y;
-    stbi_info(cubeMapsFaceNames[0], &isize_x, &isize_y, nullptr);
-    uint32_t size_x = isize_x, size_y = isize_y;
+    auto const cubeMapInfo = pAssets->GetCubeMapInfo();
+    uint32_t size_x = cubeMapInfo.extent.width, size_y = cubeMapInfo.extent.height;
+
+    // Levels follow each other in the staging buffer and every level keeps all faces, like in the container
+    cubeMapLevelOffsets.assign(cubeMapInfo.levelsNum + 1U, 0U);
+    for (uint32_t levelIdx = 0U; levelIdx < cubeMapInfo.levelsNum; levelIdx++) {
+        VkDeviceSize const levelSize = pAssets->IsCubeMapContainerUsed() ? pAssets->GetCubeMapLevel(levelIdx).size :
+            cubeMapFacesNum*size_x*size_y*4U*sizeof(uint8_t);
+        cubeMapLevelOffsets[levelIdx + 1U] = cubeMapLevelOffsets[levelIdx] + levelSize;
+    }
 
     Utils::CreateBufferInfo stagingBufferCI {
-        .size = cubeMapFacesNum*size_x*size_y*4U*sizeof(uint8_t),
+        .size = cubeMapLevelOffsets.back(),
         .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         .name = "BlackHolePass::StagingBuffer"
     };
 
-    pStagingBuffer = &gpuAllocator.AddBuffer(device, stagingBufferCI, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0U);
+    // Coherent memory doesn't need flushes of faces, which are written by several jobs
+    pStagingBuffer = &gpuAllocator.AddBuffer(device, stagingBufferCI,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0U);
+
+    // Decoded faces have a single level, the rest of the mip chain is generated by blits at the first frame
+    VkExtent3D const extent = {size_x, size_y, 1U};
+    isCubeMapMipChainGenerated = !pAssets->IsCubeMapContainerUsed();
+    cubeMapLevelsNum = isCubeMapMipChainGenerated ? Utils::GetMipLevelsNum(extent) : cubeMapInfo.levelsNum;
 
     Utils::CreateImageInfo cubeMapCI {
         .type = VK_IMAGE_TYPE_2D,
         .viewType = VK_IMAGE_VIEW_TYPE_CUBE,
         .flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
-        .extent = {
-            .width = size_x,
-            .height = size_y,
-            .depth = 1U
-        },
+        .format = cubeMapInfo.format,
+        .extent = extent,
+        .mipLayers = cubeMapLevelsNum,
         .arrayLayers = cubeMapFacesNum,
-        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
         .name = "BlackHolePass::CubeMap"
     };
 
     pCubeMap = &gpuAllocator.AddImage(device, cubeMapCI);
 }
 
-void BlackHolePass::LoadCubeMap(VkDevice device, VkCommandBuffer commandBuffer) {
-    Utils::DebugUtils::LabelGuard loadGuard(commandBuffer, "BlackHolePass::LoadCubeMap", 0.0F, 1.0F, 0.0F);
+void BlackHolePass::StartCubeMapUpload(JobSystem &jobSystem) {
+    pJobSystem = &jobSystem;
 
-    // Tricky barriers: They are executed after map operation, because we just write commands into commandBuffer
-    Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
-    Utils::ImagePipelineBarrier(commandBuffer, *pCubeMap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, 0U, cubeMapFacesNum});
-
-    std::vector<uint8_t> mappedStagingBuffer(pStagingBuffer->size);
-    void *pMappedStagingBuffer = mappedStagingBuffer.data();
-    VK_CALL(vkMapMemory(device, pStagingBuffer->deviceMemory, pStagingBuffer->deviceMemoryOffset, pStagingBuffer->size, 0U, &pMappedStagingBuffer));
-
-    auto f = [&](uint32_t faceIndex){
-        const uint32_t size_x = pCubeMap->size.width, size_y = pCubeMap->size.height;
-        int x = size_x, y = size_y, channels = 4U;
-        uint8_t *copyData = stbi_load(cubeMapsFaceNames[faceIndex], &x, &y, &channels, 0U);
+    // Levels of the mapped container are already laid out for the copy, every level is copied by its own job
+    if (pAssets->IsCubeMapContainerUsed()) {
+        for (uint32_t levelIdx = 0U; levelIdx + 1U < cubeMapLevelOffsets.size(); levelIdx++) {
+            jobSystem.Submit(cubeMapUploadGroup, [this, levelIdx](){
+                auto const level = pAssets->GetCubeMapLevel(levelIdx);
+                std::memcpy(pStagingBuffer->pMappedData + cubeMapLevelOffsets[levelIdx], level.data, level.size);
+            });
+        }
+        return;
+    }
 
-        VkDeviceSize const faceSize = pStagingBuffer->size/cubeMapFacesNum;
-        std::memcpy(static_cast<uint8_t*>(pMappedStagingBuffer) + faceSize*static_cast<VkDeviceSize>(faceIndex), copyData, faceSize);
+    // Every face is copied into its slice of the persistently mapped staging buffer as soon as it is decoded
+    VkDeviceSize const faceSize = cubeMapLevelOffsets[1U]/cubeMapFacesNum;
+    for (uint32_t faceIndex = 0U; faceIndex < cubeMapFacesNum; faceIndex++) {
+        jobSystem.Submit(cubeMapUploadGroup, [this, faceIndex, faceSize](){
+            auto const &face = pAssets->GetCubeMapFace(faceIndex);
+            if (face.extent.width != pCubeMap->size.width || face.extent.height != pCubeMap->size.height) {
+                throw std::runtime_error(std::format("[BlackHolePass] Cube map face {} differs in size from face 0", faceIndex));
+            }
 
-        VkDeviceSize bufferOffset = faceSize*static_cast<VkDeviceSize>(faceIndex);
-        VkMappedMemoryRange mappedMemoryRange {
-            .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-            .pNext = nullptr,
-            .memory = pStagingBuffer->deviceMemory,
-            .offset = pStagingBuffer->deviceMemoryOffset + bufferOffset,
-            .size = faceSize
-        };
+            std::memcpy(pStagingBuffer->pMappedData + faceSize*faceIndex, face.pixels.get(), faceSize);
+            pAssets->ReleaseCubeMapFace(faceIndex);
+        });
+    }
+}
 
-        VK_CALL(vkFlushMappedMemoryRanges(device, 1U, &mappedMemoryRange));
+void BlackHolePass::CopyCubeMap(VkCommandBuffer commandBuffer) {
+    // Faces are decoded and copied by jobs since initialization, usually they are already in the staging buffer
+    pJobSystem->Wait(cubeMapUploadGroup);
 
-        stbi_image_free(copyData);
+    VkImageSubresourceRange const cubeMapRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, cubeMapLevelsNum, 0U, cubeMapFacesNum};
 
-        // Copy buffer data to image data
-        VkBufferImageCopy bufferImageCopy {
-            .bufferOffset = bufferOffset,
+    // Staging memory is coherent, so host writes are visible at submission
+    Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    Utils::ImagePipelineBarrier(commandBuffer, *pCubeMap, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, cubeMapRange);
+
+    // All levels of the staging buffer are copied by one command, faces of a level are consecutive layers of one region
+    uint32_t const stagingLevelsNum = static_cast<uint32_t>(cubeMapLevelOffsets.size()) - 1U;
+    std::vector<VkBufferImageCopy> bufferImageCopies(stagingLevelsNum);
+    for (uint32_t levelIdx = 0U; levelIdx < stagingLevelsNum; levelIdx++) {
+        bufferImageCopies[levelIdx] = VkBufferImageCopy{
+            .bufferOffset = cubeMapLevelOffsets[levelIdx],
             .bufferRowLength = 0U,
             .bufferImageHeight = 0U,
             .imageSubresource = {
                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                .mipLevel = 0U,
-                .baseArrayLayer = faceIndex,
-                .layerCount = 1U
+                .mipLevel = levelIdx,
+                .baseArrayLayer = 0U,
+                .layerCount = cubeMapFacesNum
             },
             .imageOffset = {
                 .x = 0,
@@ -575,34 +1155,64 @@ void BlackHolePass::LoadCubeMap(VkDevice device, VkCommandBuffer commandBuffer)
                 .z = 0
             },
             .imageExtent = {
-                .width = size_x,
-                .height = size_y,
+                .width = std::max(pCubeMap->size.width >> levelIdx, 1U),
+                .height = std::max(pCubeMap->size.height >> levelIdx, 1U),
                 .depth = 1U
             }
         };
+    }
 
-        vkCmdCopyBufferToImage(commandBuffer, pStagingBuffer->buffer, pCubeMap->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &bufferImageCopy);
-    };
+    vkCmdCopyBufferToImage(commandBuffer, pStagingBuffer->buffer, pCubeMap->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        stagingLevelsNum, bufferImageCopies.data());
+}
 
-    for (uint32_t faceIndex = 0U; faceIndex < cubeMapFacesNum; faceIndex++) {
-        f(faceIndex);
-    }
+void BlackHolePass::LoadCubeMap(VkCommandBuffer commandBuffer) {
+    Utils::DebugUtils::LabelGuard loadGuard(commandBuffer, "BlackHolePass::LoadCubeMap", 0.0F, 1.0F, 0.0F);
 
-    vkUnmapMemory(device, pStagingBuffer->deviceMemory);
+    VkImageSubresourceRange const cubeMapRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, cubeMapLevelsNum, 0U, cubeMapFacesNum};
+
+    if (isCubeMapMipChainGenerated) {
+        Utils::GenerateMipLevels(commandBuffer, *pCubeMap, cubeMapLevelsNum, cubeMapFacesNum);
+    }
 
     Utils::ImagePipelineBarrier(commandBuffer, *pCubeMap, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, 0U, cubeMapFacesNum});
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, cubeMapRange);
 }
 
-#ifdef BLACK_HOLE_RAY_QUERY
+void BlackHolePass::AllocateMarchingBuffers(VkDevice device, Utils::GPUAllocator &gpuAllocator) {
+    // Every traced pixel has its own slot of the ray state
+    VkDeviceSize const rayCount = static_cast<VkDeviceSize>(WINDOW_SIZE_WIDTH)*WINDOW_SIZE_HEIGHT;
+
+    Utils::CreateBufferInfo rayStatesBufferCI {
+        .size = rayCount*WAVEFRONT_RAY_STATE_SIZE,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .name = "BlackHolePass::Wavefront Ray States Buffer"
+    };
+    pWavefrontRayStatesBuffer = &gpuAllocator.AddBuffer(device, rayStatesBufferCI);
+
+    // Headers of all passes and two ping-pong halves of entries, each of them fits all rays
+    Utils::CreateBufferInfo rayQueuesBufferCI {
+        .size = WAVEFRONT_PASS_COUNT*sizeof(glm::uvec4) + 2ULL*rayCount*sizeof(uint32_t),
+        .usage = (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+        .name = "BlackHolePass::Wavefront Ray Queues Buffer"
+    };
+    pWavefrontRayQueuesBuffer = &gpuAllocator.AddBuffer(device, rayQueuesBufferCI);
+
+    Utils::CreateBufferInfo workCounterBufferCI {
+        .size = sizeof(uint32_t),
+        .usage = (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+        .name = "BlackHolePass::Persistent Threads Work Counter Buffer"
+    };
+    pPersistentThreadsWorkCounterBuffer = &gpuAllocator.AddBuffer(device, workCounterBufferCI);
+}
 
 void BlackHolePass::AllocateBottomLevelASes(VkDevice device, Utils::GPUAllocator &gpuAllocator, uint32_t num) {
     blasInfos.resize(num);
 
     for (uint32_t idx = 0U; idx < num; idx++) {
         auto &blasInfo = blasInfos[idx];
-        auto &objData = blasInfo.objData;
-        objData.Init(std::format("objects/obj{}.obj", idx));
+        auto const &objData = pAssets->GetObject(idx);
+        blasInfo.pObjData = &objData;
         blasInfo.transformMatrix = blasTransformMatrices[idx];
 
         VkAccelerationStructureGeometryTrianglesDataKHR const geometryTrianglesData {
@@ -733,10 +1343,8 @@ void BlackHolePass::AllocateBottomLevelASes(VkDevice device, Utils::GPUAllocator
         blasInfo.pTexCoordIndicesBuffer = &gpuAllocator.AddBuffer(device, texCoordIndicesBufferCI);
 
         // Texture Zone
-        blasInfo.textureFileName = std::format("textures/obj{}.png", idx);
-        int isize_x, isize_y;
-        stbi_info(blasInfo.textureFileName.c_str(), &isize_x, &isize_y, nullptr);
-        uint32_t size_x = isize_x, size_y = isize_y;
+        VkExtent2D const textureExtent = pAssets->GetObjectTextureExtent(idx);
+        uint32_t size_x = textureExtent.width, size_y = textureExtent.height;
 
         Utils::CreateBufferInfo stagingBufferCI {
             .size = size_x*size_y*4U*sizeof(uint8_t),
@@ -745,89 +1353,56 @@ void BlackHolePass::AllocateBottomLevelASes(VkDevice device, Utils::GPUAllocator
         };
         blasInfo.pStagingBuffer = &gpuAllocator.AddBuffer(device, stagingBufferCI, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, 0U);
 
+        VkExtent3D const extent = {size_x, size_y, 1U};
+        blasInfo.textureLevelsNum = Utils::GetMipLevelsNum(extent);
+
         Utils::CreateImageInfo textureCI {
-            .extent = {
-                .width = size_x,
-                .height = size_y,
-                .depth = 1U
-            },
-            .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .extent = extent,
+            .mipLayers = blasInfo.textureLevelsNum,
+            .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
             .name = std::format("BlackHolePass::Bottom Level AS Texture [{}]", idx)
         };
         blasInfo.pTexture = &gpuAllocator.AddImage(device, textureCI);
     }
-}
-
-void BlackHolePass::BuildBottomLevelASes(VkDevice device, VkCommandBuffer commandBuffer) {
-    Utils::DebugUtils::LabelGuard loadGuard(commandBuffer, "BuildBottomLevelAS", 0.5F, 0.0F, 0.5F);
 
-    VkBufferDeviceAddressInfo bufferDeviceAddressInfo {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-        .pNext = nullptr,
-        .buffer = pScratchBuffer->buffer
+    // Addresses of texture coordinate and vertex buffers, they are indexed by instance custom index in the shader
+    Utils::CreateBufferInfo blasAddressesBufferCI {
+        .size = 4U*NUM_OF_BLAS_TEXTURES*sizeof(VkDeviceAddress),
+        .usage = (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+        .name = "BlackHolePass::Bottom Level AS Addresses Buffer"
     };
-    VkDeviceAddress scratchBufferDeviceAddress = ((vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo) + 255ULL) & (~255ULL));
-
-    for (auto &blasInfo : blasInfos) {
-        VkBuffer vertexBuffer = blasInfo.pVertexBuffer->buffer;
-        auto const &vertexData = blasInfo.objData.GetVertices();
-        vkCmdUpdateBuffer(commandBuffer, vertexBuffer, 0ULL, vertexData.size()*sizeof(float), vertexData.data());
-
-        VkBuffer indexBuffer = blasInfo.pIndexBuffer->buffer;
-        auto const &indexData = blasInfo.objData.GetVertexIndices();
-        vkCmdUpdateBuffer(commandBuffer, indexBuffer, 0ULL, indexData.size()*sizeof(uint32_t), indexData.data());
-
-        Utils::MemoryPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
-            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_SHADER_READ_BIT);
-
-        VkBuffer texCoordsBuffer = blasInfo.pTexCoordsBuffer->buffer;
-        auto const &texCoordsData = blasInfo.objData.GetTexCoords();
-        vkCmdUpdateBuffer(commandBuffer, texCoordsBuffer, 0ULL, texCoordsData.size()*sizeof(float), texCoordsData.data());
+    pBlasAddressesBuffer = &gpuAllocator.AddBuffer(device, blasAddressesBufferCI);
+}
 
-        VkBuffer texCoordIndicesBuffer = blasInfo.pTexCoordIndicesBuffer->buffer;
-        auto const &texCoordIndicesData = blasInfo.objData.GetTexCoordIndices();
-        vkCmdUpdateBuffer(commandBuffer, texCoordIndicesBuffer, 0ULL, texCoordIndicesData.size()*sizeof(uint32_t), texCoordIndicesData.data());
+void BlackHolePass::CopyBottomLevelASData(VkDevice device, VkCommandBuffer commandBuffer) {
+    Utils::DebugUtils::LabelGuard copyGuard(commandBuffer, "CopyBottomLevelASData", 0.5F, 0.0F, 0.5F);
 
-        Utils::MemoryPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
-
-        bufferDeviceAddressInfo.buffer = texCoordsBuffer;
-        texCoordsDeviceAddress.push_back(vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo));
-        bufferDeviceAddressInfo.buffer = texCoordIndicesBuffer;
-        texCoordIndicesDeviceAddress.push_back(vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo));
+    for (uint32_t idx = 0U; idx < blasInfos.size(); idx++) {
+        auto &blasInfo = blasInfos[idx];
+        auto const &vertexData = blasInfo.pObjData->GetVertices();
+        vkCmdUpdateBuffer(commandBuffer, blasInfo.pVertexBuffer->buffer, 0ULL, vertexData.size()*sizeof(float), vertexData.data());
 
-        VkAccelerationStructureGeometryTrianglesDataKHR &geometryTrianglesData = blasInfo.geometry.geometry.triangles;
-        bufferDeviceAddressInfo.buffer = vertexBuffer;
-        geometryTrianglesData.vertexData.deviceAddress = vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo);
-        bufferDeviceAddressInfo.buffer = indexBuffer;
-        geometryTrianglesData.indexData.deviceAddress = vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo);
-        blasInfo.buildGeometryInfo.scratchData.deviceAddress = scratchBufferDeviceAddress;
+        auto const &indexData = blasInfo.pObjData->GetVertexIndices();
+        vkCmdUpdateBuffer(commandBuffer, blasInfo.pIndexBuffer->buffer, 0ULL, indexData.size()*sizeof(uint32_t), indexData.data());
 
-        VkAccelerationStructureBuildRangeInfoKHR const *pBuildRangeInfo = &blasInfo.buildRangeInfo;
-        vkCmdBuildAccelerationStructuresKHR(commandBuffer, 1U, &blasInfo.buildGeometryInfo, &pBuildRangeInfo);
+        auto const &texCoordsData = blasInfo.pObjData->GetTexCoords();
+        vkCmdUpdateBuffer(commandBuffer, blasInfo.pTexCoordsBuffer->buffer, 0ULL, texCoordsData.size()*sizeof(float), texCoordsData.data());
 
-        Utils::MemoryPipelineBarrier(commandBuffer,
-            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-            VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
-            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-            VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+        auto const &texCoordIndicesData = blasInfo.pObjData->GetTexCoordIndices();
+        vkCmdUpdateBuffer(commandBuffer, blasInfo.pTexCoordIndicesBuffer->buffer, 0ULL, texCoordIndicesData.size()*sizeof(uint32_t), texCoordIndicesData.data());
 
         // Texture Zone
         Image* &pTexture = blasInfo.pTexture;
         Buffer* &pStagingBuffer = blasInfo.pStagingBuffer;
         const uint32_t size_x = pTexture->size.width, size_y = pTexture->size.height;
-        int x = size_x, y = size_y, channels = 4U;
-        uint8_t *copyData = stbi_load(blasInfo.textureFileName.c_str(), &x, &y, &channels, 0U);
+        uint8_t const *copyData = pAssets->GetObjectTexture(idx).pixels.get();
         VkDeviceSize copyDataSize = size_x*size_y*4U*sizeof(uint8_t);
 
         Utils::CopyMemoryIntoStagingBuffer(device, *pStagingBuffer, copyData, copyDataSize);
 
+        VkImageSubresourceRange const textureRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, blasInfo.textureLevelsNum, 0U, 1U};
         Utils::ImagePipelineBarrier(commandBuffer, *pTexture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
-
-        stbi_image_free(copyData);
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, textureRange);
 
         // Copy buffer data to image data
         VkBufferImageCopy bufferImageCopy {
@@ -853,10 +1428,65 @@ void BlackHolePass::BuildBottomLevelASes(VkDevice device, VkCommandBuffer comman
         };
 
         vkCmdCopyBufferToImage(commandBuffer, pStagingBuffer->buffer, pTexture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &bufferImageCopy);
+    }
+}
 
-        Utils::ImagePipelineBarrier(commandBuffer, *pTexture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+void BlackHolePass::BuildBottomLevelASes(VkDevice device, VkCommandBuffer commandBuffer) {
+    Utils::DebugUtils::LabelGuard loadGuard(commandBuffer, "BuildBottomLevelAS", 0.5F, 0.0F, 0.5F);
+
+    VkBufferDeviceAddressInfo bufferDeviceAddressInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .pNext = nullptr,
+        .buffer = pScratchBuffer->buffer
+    };
+    VkDeviceAddress scratchBufferDeviceAddress = ((vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo) + 255ULL) & (~255ULL));
+
+    // Geometry buffers are already filled and made visible by the acquire barrier of uploads
+    for (auto &blasInfo : blasInfos) {
+        bufferDeviceAddressInfo.buffer = blasInfo.pTexCoordsBuffer->buffer;
+        texCoordsDeviceAddress.push_back(vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo));
+        bufferDeviceAddressInfo.buffer = blasInfo.pTexCoordIndicesBuffer->buffer;
+        texCoordIndicesDeviceAddress.push_back(vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo));
+
+        VkAccelerationStructureGeometryTrianglesDataKHR &geometryTrianglesData = blasInfo.geometry.geometry.triangles;
+        bufferDeviceAddressInfo.buffer = blasInfo.pVertexBuffer->buffer;
+        geometryTrianglesData.vertexData.deviceAddress = vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo);
+        bufferDeviceAddressInfo.buffer = blasInfo.pIndexBuffer->buffer;
+        geometryTrianglesData.indexData.deviceAddress = vkGetBufferDeviceAddress(device, &bufferDeviceAddressInfo);
+        // Triangles are read by shaders too, their areas give texture levels of ray cones
+        vertexDeviceAddress.push_back(geometryTrianglesData.vertexData.deviceAddress);
+        vertexIndicesDeviceAddress.push_back(geometryTrianglesData.indexData.deviceAddress);
+        blasInfo.buildGeometryInfo.scratchData.deviceAddress = scratchBufferDeviceAddress;
+
+        VkAccelerationStructureBuildRangeInfoKHR const *pBuildRangeInfo = &blasInfo.buildRangeInfo;
+        vkCmdBuildAccelerationStructuresKHR(commandBuffer, 1U, &blasInfo.buildGeometryInfo, &pBuildRangeInfo);
+
+        Utils::MemoryPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+
+        // The first level of the texture is uploaded, the rest are blitted from it
+        VkImageSubresourceRange const textureRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, blasInfo.textureLevelsNum, 0U, 1U};
+        Utils::GenerateMipLevels(commandBuffer, *blasInfo.pTexture, blasInfo.textureLevelsNum, 1U);
+
+        Utils::ImagePipelineBarrier(commandBuffer, *blasInfo.pTexture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, textureRange);
     }
+
+    // Layout of BlasAddresses block: all texture coordinate buffers, then all texture coordinate index buffers,
+    // then all vertex buffers and all vertex index buffers
+    std::array<VkDeviceAddress, 4U*NUM_OF_BLAS_TEXTURES> blasAddresses{};
+    std::ranges::copy(texCoordsDeviceAddress, blasAddresses.begin());
+    std::ranges::copy(texCoordIndicesDeviceAddress, blasAddresses.begin() + NUM_OF_BLAS_TEXTURES);
+    std::ranges::copy(vertexDeviceAddress, blasAddresses.begin() + 2U*NUM_OF_BLAS_TEXTURES);
+    std::ranges::copy(vertexIndicesDeviceAddress, blasAddresses.begin() + 3U*NUM_OF_BLAS_TEXTURES);
+    vkCmdUpdateBuffer(commandBuffer, pBlasAddressesBuffer->buffer, 0ULL, sizeof(blasAddresses), blasAddresses.data());
+
+    Utils::MemoryPipelineBarrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 }
 
 void BlackHolePass::AllocateTopLevelAS(VkDevice device, Utils::GPUAllocator &gpuAllocator) {
@@ -1023,6 +1653,4 @@ void BlackHolePass::BuildTopLevelAS(VkDevice device, VkCommandBuffer commandBuff
         VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
 }
 
-#endif // BLACK_HOLE_RAY_QUERY
-
 }
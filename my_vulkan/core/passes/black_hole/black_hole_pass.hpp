@@ -1,13 +1,23 @@
 #pragma once
 
 #include "../base_pass.hpp"
-#include "utils/camera.hpp"
+#include <glm/glm.hpp>
 #include "utils/obj_data.hpp"
+#include "utils/job_system.hpp"
+#include "my_vulkan/core/render_mode.hpp"
+#include "black_hole_specialization.hpp"
+#include "black_hole_assets.hpp"
+#include "my_vulkan/shaders/black_hole.in"
+
+#include <array>
+#include <vector>
+
 namespace KRV {
 
 class BlackHolePass final : public BasePass {
 public:
-    BlackHolePass() = default;
+    // Assets are decoded by jobs, the pass waits for them only when it consumes them
+    BlackHolePass(bool isRayQuerySupported, BlackHoleSpecialization const &specialization, BlackHoleAssets &assets);
 
     BlackHolePass(BlackHolePass const &) = delete;
     BlackHolePass& operator=(BlackHolePass const &) = delete;
@@ -17,41 +27,119 @@ public:
     ~BlackHolePass() = default;
 
     void AllocateResources(VkDevice device, Utils::GPUAllocator &gpuAllocator) override;
-    void Init(VkDevice device) override;
+    void Init(VkDevice device, VkPipelineCache pipelineCache, JobSystem &jobSystem) override;
     void Destroy(VkDevice device) override;
     void RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer) override;
 
+    // Copies of the sky, meshes and object textures from staging memory. They are recorded by a dedicated transfer queue
+    // before the first frame, then ownership of resources is released to the queue family of frames and
+    // the first recording acquires it. If it is not called, the first recording copies them itself.
+    void RecordUpload(VkDevice device, VkCommandBuffer commandBuffer, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
+
     Image& GetFinalImage();
 
+    void SetRenderMode(RENDER_MODE renderMode);
+    void SetRK45Tolerance(float tolerance);
+    void SetCameraPose(glm::vec3 const &position, glm::vec3 const &direction);
+
+    // 1 of factor pixels is traced per frame and the rest are reprojected from the previous frame.
+    // Factor is 1 (every pixel), 2 (checkerboard) or 4 (one pixel of 2x2 block).
+    void SetInterleaveFactor(uint32_t factor);
+
+    // Static camera image is refined by jittered samples with finer integration steps
+    void SetProgressiveRefinement(bool isEnabled);
+    // All refinement samples of the pose are accumulated, so the final image doesn't change anymore
+    bool IsConverged(glm::vec3 const &position, glm::vec3 const &direction) const;
+    bool IsRefining() const;
+
+    // Part of the final image and integration step multiplier of next frames, they are picked by the frame time governor.
+    // Render extent must be a multiple of RENDER_EXTENT_GRANULARITY.
+    void SetFrameSettings(VkExtent2D renderExtent, float stepScale);
+    // Part of the final image, which is rendered by the last recorded frame
+    VkExtent2D GetRenderExtent() const;
+
+    // Distribution of rays over invocations, it is used only by ray marching modes
+    void SetMarchingDispatch(RENDER_MODE renderMode, MARCHING_DISPATCH marchingDispatch);
+    MARCHING_DISPATCH GetMarchingDispatch(RENDER_MODE renderMode) const;
+
+    // Workgroup shape of the render mode pipeline. The pipeline is rebuilt, so the device must be idle.
+    void SetWorkgroupSize(VkDevice device, RENDER_MODE renderMode, VkExtent2D workgroupSize);
+    VkExtent2D GetWorkgroupSize(RENDER_MODE renderMode) const;
+
 private:
     void InitSampler(VkDevice device);
     void InitDescriptorSet(VkDevice device);
-    void InitPipeline(VkDevice device);
+    void InitPipeline(VkDevice device, JobSystem &jobSystem);
+    void InitRenderModePipeline(VkDevice device, RENDER_MODE mode);
+    void InitReconstructPipeline(VkDevice device);
+
+    // Reprojection is valid only if the previous frame is rendered the same way
+    bool IsHistoryUsable() const;
+    void RecordReconstruction(VkCommandBuffer commandBuffer, uint32_t frameInfo, VkExtent2D previousFrameExtent);
+    void RecordHistoryCopy(VkCommandBuffer commandBuffer);
+    void ResetWavefrontQueues(VkCommandBuffer commandBuffer);
+    void ResetPersistentThreadsWorkCounter(VkCommandBuffer commandBuffer);
+    void RecordWavefrontPasses(VkCommandBuffer commandBuffer, uint32_t wavefrontPassOffset);
 
     void AllocateCubeMap(VkDevice device, Utils::GPUAllocator &gpuAllocator);
-    void LoadCubeMap(VkDevice device, VkCommandBuffer commandBuffer);
+    // Levels of the container or decoded faces are copied into the mapped staging buffer by jobs,
+    // the upload copies them into the image by one command
+    void StartCubeMapUpload(JobSystem &jobSystem);
+    void CopyCubeMap(VkCommandBuffer commandBuffer);
+    // Mip chain generation needs blits, so it is recorded by the queue of frames
+    void LoadCubeMap(VkCommandBuffer commandBuffer);
+
+    // Release and acquire barriers of uploaded resources, they differ only in stages
+    void RecordUploadOwnershipTransfer(VkCommandBuffer commandBuffer, bool isRelease);
+
+    void AllocateMarchingBuffers(VkDevice device, Utils::GPUAllocator &gpuAllocator);
 
-#ifdef BLACK_HOLE_RAY_QUERY
     void AllocateBottomLevelASes(VkDevice device, Utils::GPUAllocator &gpuAllocator, uint32_t num);
+    // Geometry buffers and the first level of object textures
+    void CopyBottomLevelASData(VkDevice device, VkCommandBuffer commandBuffer);
     void BuildBottomLevelASes(VkDevice device, VkCommandBuffer commandBuffer);
 
     void AllocateTopLevelAS(VkDevice device, Utils::GPUAllocator &gpuAllocator);
     void BuildTopLevelAS(VkDevice device, VkCommandBuffer commandBuffer);
-#endif // BLACK_HOLE_RAY_QUERY
 
     Image *pFinalImage = nullptr;
+    // Copy of the previous final image, it is used by reprojection
+    Image *pHistoryImage = nullptr;
+    // Weighted sum of refinement samples, it is FP32 to keep precision of many samples
+    Image *pAccumulationImage = nullptr;
 
     Image *pCubeMap = nullptr;
+    // Levels of the image, only the container fills all of them from the staging buffer
+    uint32_t cubeMapLevelsNum = 1U;
+    bool isCubeMapMipChainGenerated = false;
+    // Offsets of levels in the staging buffer, the last one is its size
+    std::vector<VkDeviceSize> cubeMapLevelOffsets{};
     Buffer *pStagingBuffer = nullptr;
     bool isFirstRecording = true;
+    // Uploads are recorded once, queue families are ignored if they are recorded into the first frame
+    bool isUploadRecorded = false;
+    uint32_t uploadSrcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t uploadDstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    // Non-owning, it is kept by Core
+    BlackHoleAssets *pAssets = nullptr;
+    JobSystem *pJobSystem = nullptr;
+    JobSystem::Group cubeMapUploadGroup{};
+
+    bool isRayQuerySupported = false;
+    BlackHoleSpecialization specialization{};
+    // Specialization per render mode, they differ only in workgroup shape
+    std::array<BlackHoleSpecialization, RENDER_MODE_COUNT> modeSpecializations{};
+    RENDER_MODE renderMode = DEFAULT_RENDER_MODE;
+    float rk45Tolerance = RK45_DEFAULT_TOLERANCE;
 
-#if defined(BLACK_HOLE_PRECOMPUTED)
     // Just take it from precompute pass, there is no allocation of this resource.
     Image *pPrecomputedPhiTexture = nullptr;
     Image *pPrecomputedAccrDiskDataTexture = nullptr;
-#elif defined(BLACK_HOLE_RAY_QUERY)
+
+    // Ray query resources, they are allocated only if ray query is supported.
     struct BlasInfo final {
-        OBJData objData;
+        OBJData const *pObjData = nullptr;
         VkTransformMatrixKHR transformMatrix{};
         VkAccelerationStructureBuildRangeInfoKHR buildRangeInfo{};
         VkAccelerationStructureGeometryKHR geometry{};
@@ -62,8 +150,8 @@ private:
         Buffer *pVertexBuffer = nullptr;
         Buffer *pIndexBuffer = nullptr;
         Buffer *pUnderlyingBLASBuffer = nullptr;
-        std::string textureFileName = "";
         Image *pTexture = nullptr;
+        uint32_t textureLevelsNum = 1U;
         Buffer *pStagingBuffer = nullptr;
     };
 
@@ -81,19 +169,49 @@ private:
     TlasInfo tlasInfo{};
     std::vector<VkDeviceAddress> texCoordsDeviceAddress;
     std::vector<VkDeviceAddress> texCoordIndicesDeviceAddress;
+    std::vector<VkDeviceAddress> vertexDeviceAddress;
+    std::vector<VkDeviceAddress> vertexIndicesDeviceAddress;
+    Buffer *pBlasAddressesBuffer = nullptr;
     // General scratch buffer for all acceleration structures.
     VkDeviceSize scratchBufferSize = 0ULL;
     Buffer *pScratchBuffer = nullptr;
-#endif // BLACK_HOLE_PRECOMPUTED, BLACK_HOLE_RAY_QUERY
 
     VkSampler sampler = VK_NULL_HANDLE;
-    VkPipeline pipeline = VK_NULL_HANDLE;
+    // Not owned, render mode pipelines are rebuilt through it too
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    // Pipeline per render mode, unsupported ones are VK_NULL_HANDLE.
+    std::array<VkPipeline, RENDER_MODE_COUNT> pipelines{};
+    VkPipeline reconstructPipeline = VK_NULL_HANDLE;
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
     VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
     VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
 
-    Camera camera = Camera(glm::vec3(-0.3F, 0.3F, +0.05F), glm::vec3(1.0F, -1.0F, -0.2F), 0.1F, 1.0F, 1.57F);
+    glm::vec3 cameraPosition = glm::vec3(0.0F);
+    glm::vec3 cameraDirection = glm::vec3(1.0F, 0.0F, 0.0F);
+
+    uint32_t interleaveFactor = 1U;
+    uint32_t interleavePhase = 0U;
+    bool isHistoryValid = false;
+    glm::vec3 previousCameraPosition = glm::vec3(0.0F);
+    glm::vec3 previousCameraDirection = glm::vec3(1.0F, 0.0F, 0.0F);
+
+    // Previous frame is rendered with the same settings, so it may be compared with the current one
+    bool isPreviousFrameValid = false;
+    bool isProgressiveRefinementEnabled = true;
+    uint32_t refinementSample = 0U;
+
+    VkExtent2D renderExtent = {WINDOW_SIZE_WIDTH, WINDOW_SIZE_HEIGHT};
+    float stepScale = 1.0F;
+    VkExtent2D frameExtent = {WINDOW_SIZE_WIDTH, WINDOW_SIZE_HEIGHT};
+
+    // Dispatch per render mode, wavefront is the default one
+    std::array<MARCHING_DISPATCH, RENDER_MODE_COUNT> marchingDispatches{};
+    // Saved states of unfinished rays and their queues per pass
+    Buffer *pWavefrontRayStatesBuffer = nullptr;
+    Buffer *pWavefrontRayQueuesBuffer = nullptr;
+    // Number of pixels fetched by persistent threads
+    Buffer *pPersistentThreadsWorkCounterBuffer = nullptr;
 };
 
 }
\ No newline at end of file
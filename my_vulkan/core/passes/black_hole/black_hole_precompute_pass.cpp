@@ -6,20 +6,178 @@
 #include "my_vulkan/vulkan_functions.hpp"
 
 #include "common.hpp"
-
+#include "utils/hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
 #include <utility>
 
+namespace {
+
+constexpr char const *cacheFileName = "precomputed_tables.cache";
+constexpr char const *cacheTmpFileName = "precomputed_tables.cache.tmp";
+
+// Must be increased on every change of the file layout
+constexpr uint32_t cacheVersion = 1U;
+
+struct CacheHeader final {
+    char magic[8] = {'K', 'R', 'V', 'B', 'H', 'P', 'C', '\0'};
+    uint32_t version = cacheVersion;
+    uint32_t reserved = 0U;
+    uint64_t key = 0ULL;
+    uint64_t dataSize = 0ULL;
+};
+
+#if defined(PRECOMPUTED_TABLE_UNORM16)
+constexpr char const *tableFormatName = "UNORM16";
+constexpr VkFormat tableFormatRG = VK_FORMAT_R16G16_UNORM;
+constexpr VkFormat tableFormatRGBA = VK_FORMAT_R16G16B16A16_UNORM;
+constexpr VkDeviceSize tableComponentSize = sizeof(uint16_t);
+#elif defined(PRECOMPUTED_TABLE_FLOAT16)
+constexpr char const *tableFormatName = "FLOAT16";
+constexpr VkFormat tableFormatRG = VK_FORMAT_R16G16_SFLOAT;
+constexpr VkFormat tableFormatRGBA = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr VkDeviceSize tableComponentSize = sizeof(uint16_t);
+#else // defined(PRECOMPUTED_TABLE_FLOAT32)
+constexpr char const *tableFormatName = "FLOAT32";
+constexpr VkFormat tableFormatRG = VK_FORMAT_R32G32_SFLOAT;
+constexpr VkFormat tableFormatRGBA = VK_FORMAT_R32G32B32A32_SFLOAT;
+constexpr VkDeviceSize tableComponentSize = sizeof(float);
+#endif // PRECOMPUTED_TABLE_UNORM16, PRECOMPUTED_TABLE_FLOAT16, PRECOMPUTED_TABLE_FLOAT32
+
+#ifdef PRECOMPUTED_TABLE_PACKED
+// Phi table is FP32 scratch, which is packed into the accretion disk table: vec4(radii, phi, flag)
+constexpr bool isPacked = true;
+constexpr VkFormat phiTextureFormat = VK_FORMAT_R32G32_SFLOAT;
+constexpr VkDeviceSize phiTexelSize = 2U*sizeof(float);
+constexpr VkFormat accrDiskDataTextureFormat = tableFormatRGBA;
+constexpr VkDeviceSize accrDiskDataTexelSize = 4U*tableComponentSize;
+#else
+constexpr bool isPacked = false;
+constexpr VkFormat phiTextureFormat = tableFormatRG;
+constexpr VkDeviceSize phiTexelSize = 2U*tableComponentSize;
+constexpr VkFormat accrDiskDataTextureFormat = tableFormatRG;
+constexpr VkDeviceSize accrDiskDataTexelSize = 2U*tableComponentSize;
+#endif // PRECOMPUTED_TABLE_PACKED
+
+// Tables take not more than a quarter of the device local heap
+constexpr VkDeviceSize memoryBudgetDivisor = 4ULL;
+// u and angle resolution of the accretion disk table is not reduced below it
+constexpr uint32_t minAccrDiskDataTextureSize = 80U;
+
+// GPU time of a generation slice, so frames stay interactive and a submission is far from OS watchdog limits
+constexpr double sliceBudgetMs = 4.0;
+// Slice before any timing and every slice without timestamps, it is a few rows
+constexpr uint32_t initialSliceTexels = 1024U;
+// Texels of rows near the critical angle take much more steps, so a slice grows not faster than twice per slice
+constexpr double maxSliceGrowth = 2.0;
+constexpr uint32_t maxSliceTexels = 1U << 18U;
+// Weight of the last slice in the smoothed generation rate
+constexpr double sliceRateSmoothing = 0.5;
+// Progress of generation is printed on every step of percents
+constexpr uint32_t progressReportStep = 10U;
+
+uint64_t GetTexelsNum(VkExtent3D const &size) {
+    return uint64_t{size.width}*size.height*size.depth;
+}
+
+// Resolution of u and angle is halved, because the 3D table takes almost all memory
+void FitIntoMemoryBudget(VkDeviceSize memoryBudget, VkExtent3D &phiExtent, VkExtent3D &accrDiskDataExtent) {
+    auto const getTablesSize = [&phiExtent, &accrDiskDataExtent]() {
+        return VkDeviceSize{phiExtent.width}*phiExtent.height*phiTexelSize +
+            VkDeviceSize{accrDiskDataExtent.width}*accrDiskDataExtent.height*accrDiskDataExtent.depth*accrDiskDataTexelSize;
+    };
+
+    while ((getTablesSize() > memoryBudget) && (accrDiskDataExtent.width/2U >= minAccrDiskDataTextureSize)) {
+        accrDiskDataExtent.width /= 2U;
+        accrDiskDataExtent.height /= 2U;
+
+        if (isPacked) {
+            phiExtent.width = accrDiskDataExtent.width;
+            phiExtent.height = accrDiskDataExtent.height;
+        }
+    }
+}
+
+// Parameters of black_hole.in are compiled into the shaders, so SPIR-V covers them.
+// Specialization constants are not in SPIR-V, but only the workgroup shape of them doesn't change tables.
+uint64_t ComputeCacheKey(VkExtent3D const &phiExtent, VkExtent3D const &accrDiskDataExtent,
+    KRV::BlackHoleSpecialization const &specialization) {
+    uint64_t hash = KRV::HashFNV1aValue(cacheVersion);
+    hash = KRV::HashFNV1aValue(phiTextureFormat, hash);
+    hash = KRV::HashFNV1aValue(accrDiskDataTextureFormat, hash);
+    hash = KRV::HashFNV1aValue(isPacked, hash);
+    for (float const value : {specialization.blackHoleRadius, specialization.precomputeStep, specialization.precomputeTanStopIter}) {
+        hash = KRV::HashFNV1aValue(value, hash);
+    }
+    hash = KRV::HashFNV1aValue(specialization.precomputeMaxSteps, hash);
+    for (uint32_t const size : {phiExtent.width, phiExtent.height,
+        accrDiskDataExtent.width, accrDiskDataExtent.height, accrDiskDataExtent.depth}) {
+        hash = KRV::HashFNV1aValue(size, hash);
+    }
+
+    for (auto const id : {KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_PHI_TEXTURE_COMP,
+        KRV::Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_ACCR_DISK_DATA_TEXTURE_COMP}) {
+        auto const &code = KRV::Utils::GetShaderCode(id);
+        hash = KRV::HashFNV1a(code.data(), code.size()*sizeof(uint32_t), hash);
+    }
+
+    return hash;
+}
+
+VkBufferImageCopy ChunkCopyRegion(VkDeviceSize bufferOffset, VkOffset3D offset, VkExtent3D extent) {
+    return VkBufferImageCopy {
+        .bufferOffset = bufferOffset,
+        .bufferRowLength = 0U,
+        .bufferImageHeight = 0U,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0U,
+            .baseArrayLayer = 0U,
+            .layerCount = 1U
+        },
+        .imageOffset = offset,
+        .imageExtent = extent
+    };
+}
+
+}
+
 namespace KRV {
 
+BlackHolePrecomputePass::BlackHolePrecomputePass(VkPhysicalDevice physicalDevice, BlackHoleSpecialization const &specialization,
+    double timestampPeriodMs, bool isSupported) : physicalDevice(physicalDevice), specialization(specialization),
+    isSupported(isSupported), timestampPeriodMs(timestampPeriodMs) {}
+
 void BlackHolePrecomputePass::AllocateResources(VkDevice device, Utils::GPUAllocator& gpuAllocator) {
+    VkExtent3D phiExtent {
+        .width = isPacked ? PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_WIDTH : PRECOMPUTED_PHI_TEXTURE_WIDTH,
+        .height = isPacked ? PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_HEIGHT : PRECOMPUTED_PHI_TEXTURE_HEIGHT,
+        .depth = 1U
+    };
+
+    VkExtent3D accrDiskDataExtent {
+        .width = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_WIDTH,
+        .height = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_HEIGHT,
+        .depth = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_DEPTH
+    };
+
+    FitIntoMemoryBudget(gpuAllocator.GetDeviceLocalHeapSize()/memoryBudgetDivisor, phiExtent, accrDiskDataExtent);
+
+    if (accrDiskDataExtent.width != PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_WIDTH) {
+        std::cout << std::format("[BlackHolePrecomputePass] Accretion disk table is reduced to {}x{}x{} to fit the memory budget",
+            accrDiskDataExtent.width, accrDiskDataExtent.height, accrDiskDataExtent.depth) << std::endl;
+    }
+
     Utils::CreateImageInfo precomputedPhiTextureCI {
-        .format = VK_FORMAT_R32G32_SFLOAT,
-        .extent {
-            .width = PRECOMPUTED_PHI_TEXTURE_WIDTH,
-            .height = PRECOMPUTED_PHI_TEXTURE_HEIGHT,
-            .depth = 1U
-        },
-        .usage = (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT),
+        .format = phiTextureFormat,
+        .extent = phiExtent,
+        .usage = (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT),
         .name = PRECOMPUTED_PHI_TEXTURE_NAME
     };
 
@@ -28,25 +186,42 @@ void BlackHolePrecomputePass::AllocateResources(VkDevice device, Utils::GPUAlloc
     Utils::CreateImageInfo precomputedAccrDiskDataTextureCI {
         .type = VK_IMAGE_TYPE_3D,
         .viewType = VK_IMAGE_VIEW_TYPE_3D,
-        .format = VK_FORMAT_R32G32_SFLOAT,
-        .extent {
-            .width = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_WIDTH,
-            .height = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_HEIGHT,
-            .depth = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_DEPTH
-        },
-        .usage = (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT),
+        .format = accrDiskDataTextureFormat,
+        .extent = accrDiskDataExtent,
+        .usage = (VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT),
         .name = PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_NAME
     };
 
     pPrecomputedAccrDiskDataTexture = &gpuAllocator.AddImage(device, precomputedAccrDiskDataTextureCI);
+    pSliceImage = pPrecomputedPhiTexture;
+
+    cacheKey = ComputeCacheKey(phiExtent, accrDiskDataExtent, specialization);
+
+    Utils::CreateBufferInfo errorBufferCI {
+        .size = sizeof(TableError),
+        .usage = (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+        .name = "BlackHolePrecomputePass::ErrorBuffer"
+    };
+
+    pErrorBuffer = &gpuAllocator.AddBuffer(device, errorBufferCI,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0U);
 }
 
-void BlackHolePrecomputePass::Init(VkDevice device) {
+void BlackHolePrecomputePass::Init(VkDevice device, VkPipelineCache pipelineCache, JobSystem &jobSystem) {
+    this->pipelineCache = pipelineCache;
     InitDescriptorSet(device);
-    InitPipeline(device);
+    InitPipeline(device, jobSystem);
+    InitTimestampQueryPool(device);
+
+    // Sizes of images are known only after GPUAllocator::PresentResources
+    InitChunks();
+    OpenCache();
 }
 
 void BlackHolePrecomputePass::Destroy(VkDevice device) {
+    stagingAllocator.Destroy(device);
+    vkDestroyQueryPool(device, std::exchange(timestampQueryPool, VK_NULL_HANDLE), nullptr);
     vkDestroyPipeline(device, std::exchange(precomputePhiPipeline, VK_NULL_HANDLE), nullptr);
     vkDestroyPipeline(device, std::exchange(precomputeAccrDiskDataPipeline, VK_NULL_HANDLE), nullptr);
     vkDestroyPipelineLayout(device, std::exchange(pipelineLayout, VK_NULL_HANDLE), nullptr);
@@ -55,32 +230,461 @@ void BlackHolePrecomputePass::Destroy(VkDevice device) {
 }
 
 void BlackHolePrecomputePass::RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer) {
-    if (!isFirstRecording) {
+    if (state == STATE::READY) {
         return;
     }
 
     Utils::DebugUtils::LabelGuard labelGuard(commandBuffer, "BlackHolePrecomputePass", 0.0F, 0.5F, 0.0F);
 
+    switch (state) {
+        case STATE::GENERATE:
+            if (RecordGeneration(device, commandBuffer)) {
+                StartDownload();
+            }
+            break;
+        case STATE::ACQUIRE:
+            RecordOwnershipTransfer(commandBuffer, false);
+            StartDownload();
+            break;
+        case STATE::UPLOAD:
+            RecordUpload(device, commandBuffer);
+            break;
+        case STATE::DOWNLOAD:
+            RecordDownload(device, commandBuffer);
+            break;
+        default:
+            break;
+    }
+
+    recordingIdx++;
+}
+
+bool BlackHolePrecomputePass::IsReady() const {
+    return state == STATE::DOWNLOAD || state == STATE::READY;
+}
+
+bool BlackHolePrecomputePass::IsGenerationNeeded() const {
+    return (state == STATE::GENERATE && generatedTexels == 0ULL) || state == STATE::GENERATE_ASYNC;
+}
+
+void BlackHolePrecomputePass::RecordAsyncGeneration(VkDevice device, VkCommandBuffer commandBuffer,
+    uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) {
+    Utils::DebugUtils::LabelGuard labelGuard(commandBuffer, "BlackHolePrecomputePass::AsyncGeneration", 0.0F, 0.5F, 0.0F);
+
+    this->srcQueueFamilyIndex = srcQueueFamilyIndex;
+    this->dstQueueFamilyIndex = dstQueueFamilyIndex;
+
+    // Tables stay on the async compute queue between slices
+    if (RecordGeneration(device, commandBuffer)) {
+        RecordOwnershipTransfer(commandBuffer, true);
+    }
+
+    state = STATE::GENERATING;
+    recordingIdx++;
+}
+
+void BlackHolePrecomputePass::FinishAsyncGeneration() {
+    if (state == STATE::GENERATING) {
+        state = (pSliceImage == nullptr) ? STATE::ACQUIRE : STATE::GENERATE_ASYNC;
+    }
+}
+
+void BlackHolePrecomputePass::InitTimestampQueryPool(VkDevice device) {
+    if (timestampPeriodMs <= 0.0) {
+        return;
+    }
+
+    VkQueryPoolCreateInfo queryPoolCI {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0U,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 2U*STAGING_BUFFER_COUNT,
+        .pipelineStatistics = 0U
+    };
+
+    VK_CALL(vkCreateQueryPool(device, &queryPoolCI, nullptr, &timestampQueryPool));
+
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_QUERY_POOL, timestampQueryPool, "BlackHolePrecomputePass::TimestampQueryPool");
+}
+
+void BlackHolePrecomputePass::InitChunks() {
+    // Chunks are rows of the 2D table and slices of the 3D table, they are stored in the file one by one
+    // Packed phi table is a scratch, there is no need to cache it
+    std::vector<std::pair<Image*, VkDeviceSize>> cachedTables{};
+    if (!isPacked) {
+        cachedTables.emplace_back(pPrecomputedPhiTexture, phiTexelSize);
+    }
+    cachedTables.emplace_back(pPrecomputedAccrDiskDataTexture, accrDiskDataTexelSize);
+
+    VkDeviceSize fileOffset = 0ULL;
+    for (auto const [pImage, texelSize] : cachedTables) {
+        VkExtent3D const &size = pImage->size;
+        bool const is3D = (size.depth > 1U);
+
+        uint32_t const numOfLayers = is3D ? size.depth : size.height;
+        VkDeviceSize const layerSize = is3D ? size.width*size.height*texelSize : size.width*texelSize;
+        uint32_t const layersPerChunk = std::max(static_cast<uint32_t>(STAGING_BUFFER_SIZE/layerSize), 1U);
+
+        for (uint32_t layer = 0U; layer < numOfLayers; layer += layersPerChunk) {
+            uint32_t const count = std::min(layersPerChunk, numOfLayers - layer);
+
+            Chunk chunk {
+                .pImage = pImage,
+                .offset = {0, is3D ? 0 : static_cast<int32_t>(layer), is3D ? static_cast<int32_t>(layer) : 0},
+                .extent = {size.width, is3D ? size.height : count, is3D ? count : 1U},
+                .fileOffset = fileOffset,
+                .size = count*layerSize
+            };
+
+            fileOffset += chunk.size;
+            chunks.push_back(chunk);
+        }
+    }
+
+    pendingChunks.fill(NO_CHUNK);
+}
+
+void BlackHolePrecomputePass::OpenCache() {
+    auto pFile = std::make_unique<MappedFile>(cacheFileName);
+    if (!pFile->IsOpen() || pFile->GetSize() < sizeof(CacheHeader)) {
+        return;
+    }
+
+    CacheHeader const expectedHeader {
+        .key = cacheKey,
+        .dataSize = chunks.back().fileOffset + chunks.back().size
+    };
+
+    CacheHeader header{};
+    std::memcpy(&header, pFile->GetData(), sizeof(CacheHeader));
+
+    bool const isValid = (std::memcmp(header.magic, expectedHeader.magic, sizeof(header.magic)) == 0) &&
+        (header.version == expectedHeader.version) && (header.key == expectedHeader.key) &&
+        (header.dataSize == expectedHeader.dataSize) && (pFile->GetSize() == sizeof(CacheHeader) + header.dataSize);
+
+    if (!isValid) {
+        std::cout << "[BlackHolePrecomputePass] Cache is outdated, tables will be regenerated" << std::endl;
+        return;
+    }
+
+    pCacheFile = std::move(pFile);
+    state = STATE::UPLOAD;
+}
+
+bool BlackHolePrecomputePass::RecordGeneration(VkDevice device, VkCommandBuffer commandBuffer) {
+    uint32_t const timestampIdx = 2U*static_cast<uint32_t>(recordingIdx % STAGING_BUFFER_COUNT);
+    uint32_t const texelBudget = GetSliceTexelBudget(device);
+
+    if (generatedTexels == 0ULL) {
+        vkCmdFillBuffer(commandBuffer, pErrorBuffer->buffer, 0ULL, VK_WHOLE_SIZE, 0U);
+        Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+        Utils::ImagePipelineBarrier(commandBuffer, *pPrecomputedPhiTexture,
+            VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+        Utils::ImagePipelineBarrier(commandBuffer, *pPrecomputedAccrDiskDataTexture,
+            VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    } else {
+        // Packed accretion disk table reads phi scratch of previous slices, all slices update the error buffer
+        Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    }
+
+    Slice const slice = NextSlice(texelBudget);
+    uint32_t const sliceTexels = slice.pImage->size.width*slice.rows*slice.layers;
+
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool, timestampIdx, 2U);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, timestampIdx);
+    }
+
+#pragma pack(push, 1)
+    struct PushConst final {
+        uint32_t sliceOffset[3];
+        uint32_t sliceRows;
+    } pushConst {
+        .sliceOffset = {0U, slice.row, slice.layer},
+        .sliceRows = slice.rows
+    };
+#pragma pack(pop)
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, slice.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0U, 1U, &descriptorSet, 0U, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0U, sizeof(PushConst), &pushConst);
+    vkCmdDispatch(commandBuffer, specialization.GetGroupCountX(slice.pImage->size.width),
+        specialization.GetGroupCountY(slice.rows), slice.layers);
+
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, timestampIdx + 1U);
+        pendingSliceTexels[timestampIdx/2U] = sliceTexels;
+    }
+
+    lastSliceTexels = sliceTexels;
+    generatedTexels += sliceTexels;
+    ReportProgress();
+
+    if (pSliceImage != nullptr) {
+        return false;
+    }
+
+    // Errors are reported after the tables are saved
+    Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+
     Utils::ImagePipelineBarrier(commandBuffer, *pPrecomputedPhiTexture,
-        VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
     Utils::ImagePipelineBarrier(commandBuffer, *pPrecomputedAccrDiskDataTexture,
-        VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, precomputePhiPipeline);
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0U, 1U, &descriptorSet, 0U, nullptr);
-    vkCmdDispatch(commandBuffer, PRECOMPUTED_PHI_TEXTURE_WIDTH/LOCAL_SIZE_X, PRECOMPUTED_PHI_TEXTURE_HEIGHT/LOCAL_SIZE_Y, 1U);
+    return true;
+}
+
+BlackHolePrecomputePass::Slice BlackHolePrecomputePass::NextSlice(uint32_t texelBudget) {
+    VkExtent3D const &size = pSliceImage->size;
+    uint32_t const layerTexels = size.width*size.height;
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, precomputeAccrDiskDataPipeline);
-    // There is no need to use `vkCmdBindDescriptorSets` because pipelineLayout is the same
-    vkCmdDispatch(commandBuffer, PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_WIDTH/LOCAL_SIZE_X,
-        PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_HEIGHT/LOCAL_SIZE_Y, PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_DEPTH);
+    Slice slice {
+        .pImage = pSliceImage,
+        .pipeline = (pSliceImage == pPrecomputedPhiTexture) ? precomputePhiPipeline : precomputeAccrDiskDataPipeline,
+        .row = sliceRow,
+        .layer = sliceLayer
+    };
+
+    // Whole layers are taken if the budget covers them, otherwise a band of rows of the current layer
+    if (sliceRow == 0U && texelBudget >= layerTexels) {
+        slice.rows = size.height;
+        slice.layers = std::min(texelBudget/layerTexels, size.depth - sliceLayer);
+        sliceLayer += slice.layers;
+    } else {
+        slice.rows = std::clamp(texelBudget/size.width, 1U, size.height - sliceRow);
+        slice.layers = 1U;
+        sliceRow += slice.rows;
+        if (sliceRow == size.height) {
+            sliceRow = 0U;
+            sliceLayer++;
+        }
+    }
+
+    if (sliceLayer == size.depth) {
+        sliceLayer = 0U;
+        pSliceImage = (pSliceImage == pPrecomputedPhiTexture) ? pPrecomputedAccrDiskDataTexture : nullptr;
+    }
+
+    return slice;
+}
+
+uint32_t BlackHolePrecomputePass::GetSliceTexelBudget(VkDevice device) {
+    uint32_t const timestampSlot = recordingIdx % STAGING_BUFFER_COUNT;
+
+    // Recording of this slot is already finished, like the one of staging buffers, so its timestamps are read without waiting
+    if (uint32_t &sliceTexels = pendingSliceTexels[timestampSlot]; sliceTexels != 0U) {
+        std::array<uint64_t, 2U> timestamps{};
+        VkResult const result = vkGetQueryPoolResults(device, timestampQueryPool, 2U*timestampSlot, 2U,
+            sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result != VK_NOT_READY) {
+            VK_CALL(result);
+        }
+
+        if (result == VK_SUCCESS && timestamps[1] > timestamps[0]) {
+            double const rate = sliceTexels/(static_cast<double>(timestamps[1] - timestamps[0])*timestampPeriodMs);
+            texelsPerMs = (texelsPerMs == 0.0) ? rate : std::lerp(texelsPerMs, rate, sliceRateSmoothing);
+        }
+        sliceTexels = 0U;
+    }
+
+    if (texelsPerMs == 0.0) {
+        return initialSliceTexels;
+    }
+
+    double const budget = std::min(texelsPerMs*sliceBudgetMs, maxSliceGrowth*lastSliceTexels);
+    return static_cast<uint32_t>(std::clamp(budget, 1.0, static_cast<double>(maxSliceTexels)));
+}
+
+void BlackHolePrecomputePass::ReportProgress() {
+    uint64_t const texelsNum = GetTexelsNum(pPrecomputedPhiTexture->size) + GetTexelsNum(pPrecomputedAccrDiskDataTexture->size);
+    uint32_t const progress = static_cast<uint32_t>(generatedTexels*100ULL/texelsNum);
+    if (progress/progressReportStep == reportedProgress/progressReportStep) {
+        return;
+    }
+
+    reportedProgress = progress;
+    std::cout << std::format("[BlackHolePrecomputePass] Tables are generated by {}%", progress) << std::endl;
+}
+
+void BlackHolePrecomputePass::RecordOwnershipTransfer(VkCommandBuffer commandBuffer, bool isRelease) {
+    // Tables keep the sampled layout, destination of the release barrier is ignored, it is given by the acquire one
+    std::array<VkImageMemoryBarrier, 2U> imageMemoryBarriers{};
+    for (uint32_t i = 0U; Image *pImage : {pPrecomputedPhiTexture, pPrecomputedAccrDiskDataTexture}) {
+        imageMemoryBarriers[i++] = VkImageMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = isRelease ? 0U : VK_ACCESS_SHADER_READ_BIT,
+            .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = srcQueueFamilyIndex,
+            .dstQueueFamilyIndex = dstQueueFamilyIndex,
+            .image = pImage->image,
+            .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, 0U, 1U}
+        };
+    }
+
+    // Source stage of the acquire barrier is the one, which waits for the timeline semaphore
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        isRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0U,
+        0U, nullptr, 0U, nullptr, static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data());
+}
+
+void BlackHolePrecomputePass::StartDownload() {
+    // Tables are saved into the cache during the next frames
+    cacheOutput.open(cacheTmpFileName, std::ios::binary | std::ios::trunc);
+    if (!cacheOutput.is_open()) {
+        std::cerr << std::format("[BlackHolePrecomputePass] Cannot create cache file {}\n", cacheTmpFileName);
+        state = STATE::READY;
+        return;
+    }
+
+    CacheHeader const header {
+        .key = cacheKey,
+        .dataSize = chunks.back().fileOffset + chunks.back().size
+    };
+    cacheOutput.write(reinterpret_cast<char const *>(&header), sizeof(CacheHeader));
+
+    chunkIdx = 0U;
+    state = STATE::DOWNLOAD;
+}
+
+void BlackHolePrecomputePass::AllocateStagingBuffers(VkDevice device) {
+    if (stagingBuffers[0] != nullptr) {
+        return;
+    }
+
+    stagingAllocator.Init(physicalDevice);
+    VkDeviceSize const stagingBufferSize = std::ranges::max(chunks, {}, &Chunk::size).size;
+
+    // Coherent memory: there is no need to flush or invalidate mapped ranges
+    for (uint32_t i = 0U; i < STAGING_BUFFER_COUNT; i++) {
+        Utils::CreateBufferInfo stagingBufferCI {
+            .size = stagingBufferSize,
+            .usage = (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+            .name = std::format("BlackHolePrecomputePass::StagingBuffer [{}]", i)
+        };
+
+        stagingBuffers[i] = &stagingAllocator.AddBuffer(device, stagingBufferCI,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0U);
+    }
+
+    stagingAllocator.PresentResources(device);
+}
+
+void BlackHolePrecomputePass::RecordUpload(VkDevice device, VkCommandBuffer commandBuffer) {
+    AllocateStagingBuffers(device);
+
+    Chunk const &chunk = chunks[chunkIdx];
+    Buffer &stagingBuffer = *stagingBuffers[recordingIdx % STAGING_BUFFER_COUNT];
+
+    // Only pages of this chunk are read from the mapped file
+    std::memcpy(stagingBuffer.pMappedData, pCacheFile->GetData() + sizeof(CacheHeader) + chunk.fileOffset, chunk.size);
+
+    Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    // Chunks don't overlap, so the image stays in transfer layout between them
+    if (chunk.pImage->layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        Utils::ImagePipelineBarrier(commandBuffer, *chunk.pImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+    }
+
+    VkBufferImageCopy const region = ChunkCopyRegion(0ULL, chunk.offset, chunk.extent);
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, chunk.pImage->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &region);
+
+    if (++chunkIdx < chunks.size()) {
+        return;
+    }
 
     Utils::ImagePipelineBarrier(commandBuffer, *pPrecomputedPhiTexture,
         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
     Utils::ImagePipelineBarrier(commandBuffer, *pPrecomputedAccrDiskDataTexture,
         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 
-    isFirstRecording = false;
+    pCacheFile.reset();
+    state = STATE::READY;
+}
+
+void BlackHolePrecomputePass::RecordDownload(VkDevice device, VkCommandBuffer commandBuffer) {
+    AllocateStagingBuffers(device);
+
+    uint32_t const stagingIdx = recordingIdx % STAGING_BUFFER_COUNT;
+    Buffer &stagingBuffer = *stagingBuffers[stagingIdx];
+
+    // Frame, which has copied this chunk, is already finished
+    if (uint32_t &pendingChunk = pendingChunks[stagingIdx]; pendingChunk != NO_CHUNK) {
+        WriteChunk(device, stagingBuffer, chunks[pendingChunk]);
+        pendingChunk = NO_CHUNK;
+    }
+
+    if (chunkIdx == chunks.size()) {
+        if (std::ranges::all_of(pendingChunks, [](uint32_t chunk){return chunk == NO_CHUNK;})) {
+            FinishDownload(device);
+        }
+        return;
+    }
+
+    Chunk const &chunk = chunks[chunkIdx];
+
+    Utils::ImagePipelineBarrier(commandBuffer, *chunk.pImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    VkBufferImageCopy const region = ChunkCopyRegion(0ULL, chunk.offset, chunk.extent);
+    vkCmdCopyImageToBuffer(commandBuffer, chunk.pImage->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer.buffer, 1U, &region);
+
+    Utils::ImagePipelineBarrier(commandBuffer, *chunk.pImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    // Make copied data available for the host after fence waiting
+    Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+
+    pendingChunks[stagingIdx] = chunkIdx++;
+}
+
+void BlackHolePrecomputePass::WriteChunk(VkDevice device, Buffer &stagingBuffer, Chunk const &chunk) {
+    cacheOutput.write(reinterpret_cast<char const *>(stagingBuffer.pMappedData), static_cast<std::streamsize>(chunk.size));
+}
+
+void BlackHolePrecomputePass::FinishDownload(VkDevice device) {
+    state = STATE::READY;
+
+    ReportError(device);
+
+    bool const isWritten = cacheOutput.good();
+    cacheOutput.close();
+
+    // Temporary file is renamed only when it is complete, so an interrupted download never looks valid
+    std::error_code error{};
+    if (isWritten) {
+        std::filesystem::remove(cacheFileName, error);
+        std::filesystem::rename(cacheTmpFileName, cacheFileName, error);
+    }
+
+    if (!isWritten || error) {
+        std::cerr << std::format("[BlackHolePrecomputePass] Cannot write cache file {}\n", cacheFileName);
+        std::filesystem::remove(cacheTmpFileName, error);
+    }
+}
+
+void BlackHolePrecomputePass::ReportError(VkDevice device) {
+    // FP32 tables are the reference
+    if (tableComponentSize == sizeof(float)) {
+        return;
+    }
+
+    TableError error{};
+    std::memcpy(&error, pErrorBuffer->pMappedData, sizeof(TableError));
+
+    std::cout << std::format("[BlackHolePrecomputePass] Max error of {} tables against FP32: phi {:.3e} rad, radius {:.3e} of black hole radius",
+        tableFormatName, error.maxPhiError, error.maxRadiusError/specialization.blackHoleRadius) << std::endl;
 }
 
 void BlackHolePrecomputePass::InitDescriptorSet(VkDevice device) {
@@ -88,6 +692,10 @@ void BlackHolePrecomputePass::InitDescriptorSet(VkDevice device) {
         {
             .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
             .descriptorCount = 2U
+        },
+        {
+            .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U
         }
     };
 
@@ -118,6 +726,13 @@ void BlackHolePrecomputePass::InitDescriptorSet(VkDevice device) {
             .descriptorCount = 1U,
             .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
             .pImmutableSamplers = nullptr
+        },
+        {
+            .binding = BINDING_PRECOMPUTED_TABLE_ERROR_BUFFER,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1U,
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr
         }
     };
 
@@ -158,6 +773,12 @@ void BlackHolePrecomputePass::InitDescriptorSet(VkDevice device) {
         },
     };
 
+    VkDescriptorBufferInfo descriptorBufferInfo {
+        .buffer = pErrorBuffer->buffer,
+        .offset = 0ULL,
+        .range = VK_WHOLE_SIZE
+    };
+
     VkWriteDescriptorSet writeDescriptors[] = {
         {
             .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -182,29 +803,70 @@ void BlackHolePrecomputePass::InitDescriptorSet(VkDevice device) {
             .pImageInfo = &descriptorImageInfos[1],
             .pBufferInfo = nullptr,
             .pTexelBufferView = nullptr
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = descriptorSet,
+            .dstBinding = BINDING_PRECOMPUTED_TABLE_ERROR_BUFFER,
+            .dstArrayElement = 0U,
+            .descriptorCount = 1U,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &descriptorBufferInfo,
+            .pTexelBufferView = nullptr
         }
     };
 
     vkUpdateDescriptorSets(device, std::size(writeDescriptors), writeDescriptors, 0U, nullptr);
 }
 
-void BlackHolePrecomputePass::InitPipeline(VkDevice device) {
+void BlackHolePrecomputePass::InitPipeline(VkDevice device, JobSystem &jobSystem) {
+    // Slice of a table: uvec3 offset and the number of rows
+    VkPushConstantRange pushConstantRanges[] = {
+        {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0U,
+            .size = 4U*sizeof(uint32_t)
+        }
+    };
+
     VkPipelineLayoutCreateInfo pipelineLayoutCI {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0U,
         .setLayoutCount = 1U,
         .pSetLayouts = &descriptorSetLayout,
-        .pushConstantRangeCount = 0U,
-        .pPushConstantRanges = nullptr
+        .pushConstantRangeCount = std::size(pushConstantRanges),
+        .pPushConstantRanges = pushConstantRanges
     };
 
     VK_CALL(vkCreatePipelineLayout(device, &pipelineLayoutCI, nullptr, &pipelineLayout));
 
     Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout, "BlackHolePrecomputePass::PipelineLayout");
 
-    Utils::ShaderModule blackHolePrecomputePhiComp = Utils::ShaderModule(device,
-        Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_PHI_TEXTURE_COMP);
+    // Shaders of 16-bit tables need StorageImageExtendedFormats, the pass isn't recorded without them
+    if (!isSupported) {
+        return;
+    }
+
+    // Pipelines are independent, so they are compiled by jobs at once
+    JobSystem::Group pipelinesGroup{};
+    jobSystem.Submit(pipelinesGroup, [this, device](){
+        InitComputePipeline(device, Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_PHI_TEXTURE_COMP,
+            precomputePhiPipeline, "BlackHolePrecomputePass::PrecomputePhiPipeline");
+    });
+    jobSystem.Submit(pipelinesGroup, [this, device](){
+        InitComputePipeline(device, Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_ACCR_DISK_DATA_TEXTURE_COMP,
+            precomputeAccrDiskDataPipeline, "BlackHolePrecomputePass::PrecomputeAccrDiskDataPipeline");
+    });
+    jobSystem.Wait(pipelinesGroup);
+}
+
+void BlackHolePrecomputePass::InitComputePipeline(VkDevice device, Utils::SHADER_LIST_ID shaderId, VkPipeline &pipeline,
+    char const *name) {
+    Utils::ShaderModule shaderModule = Utils::ShaderModule(device, shaderId);
+    VkSpecializationInfo const specializationInfo = specialization.GetInfo();
 
     VkComputePipelineCreateInfo pipelineCI {
         .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -215,29 +877,18 @@ void BlackHolePrecomputePass::InitPipeline(VkDevice device) {
             .pNext = nullptr,
             .flags = 0U,
             .stage = VK_SHADER_STAGE_COMPUTE_BIT,
-            .module = blackHolePrecomputePhiComp,
+            .module = shaderModule,
             .pName = "main",
-            .pSpecializationInfo = nullptr
+            .pSpecializationInfo = &specializationInfo
         },
         .layout = pipelineLayout,
         .basePipelineHandle = VK_NULL_HANDLE,
         .basePipelineIndex = 0U
     };
 
-    VK_CALL(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1U, &pipelineCI, nullptr, &precomputePhiPipeline));
-
-    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE, precomputePhiPipeline,
-        "BlackHolePrecomputePass::PrecomputePhiPipeline");
-
-    Utils::ShaderModule blackHolePrecomputeAccrDiskDataComp = Utils::ShaderModule(device,
-        Utils::SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_ACCR_DISK_DATA_TEXTURE_COMP);
-
-    pipelineCI.stage.module = blackHolePrecomputeAccrDiskDataComp;
-
-    VK_CALL(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1U, &pipelineCI, nullptr, &precomputeAccrDiskDataPipeline));
+    VK_CALL(vkCreateComputePipelines(device, pipelineCache, 1U, &pipelineCI, nullptr, &pipeline));
 
-    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE, precomputePhiPipeline,
-        "BlackHolePrecomputePass::PrecomputeAccrDiskDataPipeline");
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE, pipeline, name);
 }
 
 
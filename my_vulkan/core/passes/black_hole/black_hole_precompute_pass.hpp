@@ -1,12 +1,23 @@
 #pragma once
 
 #include "../base_pass.hpp"
+#include "black_hole_specialization.hpp"
+#include "utils/mapped_file.hpp"
+#include "utils/job_system.hpp"
+#include "my_vulkan/shaders/shaders_list.hpp"
+
+#include <array>
+#include <fstream>
+#include <memory>
 
 namespace KRV {
 
 class BlackHolePrecomputePass final : public BasePass {
 public:
-    BlackHolePrecomputePass() = default;
+    // Zero timestamp period means that slices of generation are not timed, so they keep their initial size.
+    // Pipelines aren't created if the device can't write tables of the table format.
+    BlackHolePrecomputePass(VkPhysicalDevice physicalDevice, BlackHoleSpecialization const &specialization,
+        double timestampPeriodMs, bool isSupported);
 
     BlackHolePrecomputePass(BlackHolePrecomputePass const &) = delete;
     BlackHolePrecomputePass& operator=(BlackHolePrecomputePass const &) = delete;
@@ -16,22 +27,132 @@ public:
     ~BlackHolePrecomputePass() = default;
 
     void AllocateResources(VkDevice device, Utils::GPUAllocator& gpuAllocator) override;
-    void Init(VkDevice device) override;
+    void Init(VkDevice device, VkPipelineCache pipelineCache, JobSystem &jobSystem) override;
     void Destroy(VkDevice device) override;
     void RecordCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer) override;
 
+    // Tables can be sampled: they are generated or completely loaded from the cache file
+    bool IsReady() const;
+
+    // Next slice of tables is going to be generated and no slice is in flight on the async compute queue.
+    // Tables are neither generated by frames nor in the cache file.
+    bool IsGenerationNeeded() const;
+    // Next slice is recorded into the command buffer of an async compute queue instead of frames.
+    // Ownership of tables is released to the queue family of frames after the last slice,
+    // and it is acquired by the frame after FinishAsyncGeneration.
+    void RecordAsyncGeneration(VkDevice device, VkCommandBuffer commandBuffer, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex);
+    // The async compute queue has signaled completion of the slice
+    void FinishAsyncGeneration();
+
 private:
+    // Tables are generated once and saved into the cache file, which is keyed by hash of shaders and parameters.
+    // On later launches the cache file is streamed into the tables instead of generation.
+    enum class STATE {
+        GENERATE,
+        // Slices are generated on the async compute queue, one submission at a time
+        GENERATE_ASYNC,
+        // Slice is in flight on the async compute queue
+        GENERATING,
+        ACQUIRE,
+        UPLOAD,
+        DOWNLOAD,
+        READY
+    };
+
+    // Part of a table, which is copied through one staging buffer per frame
+    struct Chunk final {
+        Image *pImage = nullptr;
+        VkOffset3D offset = {};
+        VkExtent3D extent = {};
+        VkDeviceSize fileOffset = 0ULL;
+        VkDeviceSize size = 0ULL;
+    };
+
+    // Band of rows or layers of a table, which is generated by one dispatch
+    struct Slice final {
+        Image *pImage = nullptr;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        uint32_t row = 0U;
+        uint32_t layer = 0U;
+        uint32_t rows = 0U;
+        uint32_t layers = 0U;
+    };
+
+    // Maximal errors of stored values against FP32 ones, see black_hole_precomputed_table.glsl
+    struct TableError final {
+        float maxPhiError = 0.0F;
+        float maxRadiusError = 0.0F;
+    };
+
+    // Recording of frame N reuses staging buffer and timestamps of frame N - FRAMES_IN_FLIGHT, its fence is already waited
+    static constexpr uint32_t STAGING_BUFFER_COUNT = FRAMES_IN_FLIGHT;
+    // Chunks are not bigger, unless a single row or layer is
+    static constexpr VkDeviceSize STAGING_BUFFER_SIZE = 32ULL*1024ULL*1024ULL;
+    static constexpr uint32_t NO_CHUNK = ~0U;
+
     void InitDescriptorSet(VkDevice device);
-    void InitPipeline(VkDevice device);
+    void InitPipeline(VkDevice device, JobSystem &jobSystem);
+    void InitComputePipeline(VkDevice device, Utils::SHADER_LIST_ID shaderId, VkPipeline &pipeline, char const *name);
+    void InitTimestampQueryPool(VkDevice device);
+    void InitChunks();
+    void OpenCache();
+
+    // Return value is true if the last slice is recorded
+    bool RecordGeneration(VkDevice device, VkCommandBuffer commandBuffer);
+    Slice NextSlice(uint32_t texelBudget);
+    uint32_t GetSliceTexelBudget(VkDevice device);
+    void ReportProgress();
+    void RecordOwnershipTransfer(VkCommandBuffer commandBuffer, bool isRelease);
+    void StartDownload();
+    // Buffers are allocated by the first upload or download as big as the largest chunk,
+    // so they don't take host visible memory if tables are never streamed
+    void AllocateStagingBuffers(VkDevice device);
+    void RecordUpload(VkDevice device, VkCommandBuffer commandBuffer);
+    void RecordDownload(VkDevice device, VkCommandBuffer commandBuffer);
+    void WriteChunk(VkDevice device, Buffer &stagingBuffer, Chunk const &chunk);
+    void FinishDownload(VkDevice device);
+    void ReportError(VkDevice device);
+
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    BlackHoleSpecialization specialization{};
+    bool isSupported = true;
 
     Image *pPrecomputedPhiTexture = nullptr;
     Image *pPrecomputedAccrDiskDataTexture = nullptr;
+    Buffer *pErrorBuffer = nullptr;
+
+    STATE state = STATE::GENERATE;
+    uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    uint64_t cacheKey = 0ULL;
+    std::unique_ptr<MappedFile> pCacheFile{};
+    std::ofstream cacheOutput{};
+
+    std::vector<Chunk> chunks{};
+    uint32_t chunkIdx = 0U;
+    Utils::GPUAllocator stagingAllocator{};
+    std::array<Buffer*, STAGING_BUFFER_COUNT> stagingBuffers{};
+    std::array<uint32_t, STAGING_BUFFER_COUNT> pendingChunks{};
+    uint64_t recordingIdx = 0ULL;
 
-    bool isFirstRecording = true;
+    // Generation cursor: the phi table is followed by the accretion disk table, which may read it
+    Image *pSliceImage = nullptr;
+    uint32_t sliceRow = 0U;
+    uint32_t sliceLayer = 0U;
+    uint64_t generatedTexels = 0ULL;
+    uint32_t reportedProgress = 0U;
+    // Slices are timed by timestamps, which are read when the slot is reused like staging buffers
+    double timestampPeriodMs = 0.0;
+    VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+    std::array<uint32_t, STAGING_BUFFER_COUNT> pendingSliceTexels{};
+    uint32_t lastSliceTexels = 0U;
+    double texelsPerMs = 0.0;
 
     VkPipeline precomputePhiPipeline = VK_NULL_HANDLE;
     VkPipeline precomputeAccrDiskDataPipeline = VK_NULL_HANDLE;
 
+    // Not owned
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
     // Common Vulkan object for pipelines.
     VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
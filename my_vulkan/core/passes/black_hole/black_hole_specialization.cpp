@@ -0,0 +1,43 @@
+#include "black_hole_specialization.hpp"
+
+#include <cstddef>
+#include <iterator>
+
+namespace {
+    using KRV::BlackHoleSpecialization;
+
+    constexpr VkSpecializationMapEntry mapEntries[] = {
+        {SPECIALIZATION_ID_LOCAL_SIZE_X, offsetof(BlackHoleSpecialization, localSizeX), sizeof(uint32_t)},
+        {SPECIALIZATION_ID_LOCAL_SIZE_Y, offsetof(BlackHoleSpecialization, localSizeY), sizeof(uint32_t)},
+        {SPECIALIZATION_ID_BLACK_HOLE_RADIUS, offsetof(BlackHoleSpecialization, blackHoleRadius), sizeof(float)},
+        {SPECIALIZATION_ID_MAX_STEPS, offsetof(BlackHoleSpecialization, maxSteps), sizeof(uint32_t)},
+        {SPECIALIZATION_ID_STEP, offsetof(BlackHoleSpecialization, step), sizeof(float)},
+        {SPECIALIZATION_ID_TAN_STOP_ITER, offsetof(BlackHoleSpecialization, tanStopIter), sizeof(float)},
+        {SPECIALIZATION_ID_PRECOMPUTE_MAX_STEPS, offsetof(BlackHoleSpecialization, precomputeMaxSteps), sizeof(uint32_t)},
+        {SPECIALIZATION_ID_PRECOMPUTE_STEP, offsetof(BlackHoleSpecialization, precomputeStep), sizeof(float)},
+        {SPECIALIZATION_ID_PRECOMPUTE_TAN_STOP_ITER, offsetof(BlackHoleSpecialization, precomputeTanStopIter), sizeof(float)},
+        {SPECIALIZATION_ID_INNER_RADIUS_OF_ACCRETION_DISK, offsetof(BlackHoleSpecialization, innerRadiusOfAccretionDisk), sizeof(float)},
+        {SPECIALIZATION_ID_OUTER_RADIUS_OF_ACCRETION_DISK, offsetof(BlackHoleSpecialization, outerRadiusOfAccretionDisk), sizeof(float)}
+    };
+}
+
+namespace KRV {
+
+VkSpecializationInfo BlackHoleSpecialization::GetInfo() const {
+    return {
+        .mapEntryCount = static_cast<uint32_t>(std::size(mapEntries)),
+        .pMapEntries = mapEntries,
+        .dataSize = sizeof(BlackHoleSpecialization),
+        .pData = this
+    };
+}
+
+uint32_t BlackHoleSpecialization::GetGroupCountX(uint32_t width) const {
+    return (width + localSizeX - 1U)/localSizeX;
+}
+
+uint32_t BlackHoleSpecialization::GetGroupCountY(uint32_t height) const {
+    return (height + localSizeY - 1U)/localSizeY;
+}
+
+}
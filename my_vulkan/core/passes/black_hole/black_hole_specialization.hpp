@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include "my_vulkan/shaders/black_hole.in"
+
+#include <cstdint>
+
+namespace KRV {
+
+// Specialization constants of black hole shaders, see black_hole_specialization.glsl.
+// They are folded by the driver, so tuning of them doesn't need a shader rebuild.
+struct BlackHoleSpecialization final {
+    uint32_t localSizeX = LOCAL_SIZE_X;
+    uint32_t localSizeY = LOCAL_SIZE_Y;
+    float blackHoleRadius = DEFAULT_BLACK_HOLE_RADIUS;
+
+    // Ray marching of render modes
+    uint32_t maxSteps = DEFAULT_MAX_STEPS;
+    float step = DEFAULT_STEP;
+    float tanStopIter = DEFAULT_TAN_STOP_ITER;
+
+    // Ray marching of precomputed tables
+    uint32_t precomputeMaxSteps = DEFAULT_PRECOMPUTE_MAX_STEPS;
+    float precomputeStep = DEFAULT_PRECOMPUTE_STEP;
+    float precomputeTanStopIter = DEFAULT_PRECOMPUTE_TAN_STOP_ITER;
+
+    // In black hole radii
+    float innerRadiusOfAccretionDisk = DEFAULT_INNER_RADIUS_OF_ACCRETION_DISK;
+    float outerRadiusOfAccretionDisk = DEFAULT_OUTER_RADIUS_OF_ACCRETION_DISK;
+
+    // Info points into this struct, so it must outlive pipeline creation
+    VkSpecializationInfo GetInfo() const;
+    // Number of workgroups, which cover the extent
+    uint32_t GetGroupCountX(uint32_t width) const;
+    uint32_t GetGroupCountY(uint32_t height) const;
+};
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+namespace KRV {
+
+enum class RENDER_MODE : uint32_t {
+    RAY_MARCHING_RK1,
+    RAY_MARCHING_RK2,
+    RAY_MARCHING_RK4,
+    RAY_QUERY,
+    PRECOMPUTED,
+    // Appended after the modes of keys 1-5, so their keys are kept
+    RAY_MARCHING_RK45,
+    ANALYTIC,
+    COUNT // Must be the last one
+};
+
+constexpr uint32_t RENDER_MODE_COUNT = static_cast<uint32_t>(RENDER_MODE::COUNT);
+
+constexpr char const *RENDER_MODE_NAMES[RENDER_MODE_COUNT] = {
+    "RAY_MARCHING_RK1",
+    "RAY_MARCHING_RK2",
+    "RAY_MARCHING_RK4",
+    "RAY_QUERY",
+    "PRECOMPUTED",
+    "RAY_MARCHING_RK45",
+    "ANALYTIC"
+};
+
+constexpr char const *GetRenderModeName(RENDER_MODE renderMode) {
+    return RENDER_MODE_NAMES[static_cast<uint32_t>(renderMode)];
+}
+
+// Modes, which integrate rays step by step
+constexpr bool IsRayMarchingMode(RENDER_MODE renderMode) {
+    return renderMode != RENDER_MODE::PRECOMPUTED && renderMode != RENDER_MODE::ANALYTIC;
+}
+
+// How rays of ray marching modes are distributed over invocations. Values match MARCHING_DISPATCH_* of black_hole.in.
+enum class MARCHING_DISPATCH : uint32_t {
+    GRID,               // Invocation per traced pixel
+    WAVEFRONT,          // Passes of growing step budgets, unfinished rays are compacted between them
+    PERSISTENT_THREADS, // Invocations fill the device and fetch next pixels, when their rays are finished
+    COUNT // Must be the last one
+};
+
+constexpr uint32_t MARCHING_DISPATCH_COUNT = static_cast<uint32_t>(MARCHING_DISPATCH::COUNT);
+
+constexpr char const *MARCHING_DISPATCH_NAMES[MARCHING_DISPATCH_COUNT] = {
+    "GRID",
+    "WAVEFRONT",
+    "PERSISTENT_THREADS"
+};
+
+constexpr char const *GetMarchingDispatchName(MARCHING_DISPATCH marchingDispatch) {
+    return MARCHING_DISPATCH_NAMES[static_cast<uint32_t>(marchingDispatch)];
+}
+
+// Mode, which is used at startup. All other modes are available in runtime too.
+#if defined(BLACK_HOLE_RAY_MARCHING_RK1)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::RAY_MARCHING_RK1;
+#elif defined(BLACK_HOLE_RAY_MARCHING_RK2)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::RAY_MARCHING_RK2;
+#elif defined(BLACK_HOLE_RAY_MARCHING_RK45)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::RAY_MARCHING_RK45;
+#elif defined(BLACK_HOLE_RAY_QUERY)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::RAY_QUERY;
+#elif defined(BLACK_HOLE_PRECOMPUTED)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::PRECOMPUTED;
+#elif defined(BLACK_HOLE_ANALYTIC)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::ANALYTIC;
+#else // defined(BLACK_HOLE_RAY_MARCHING_RK4)
+constexpr RENDER_MODE DEFAULT_RENDER_MODE = RENDER_MODE::RAY_MARCHING_RK4;
+#endif
+
+}
@@ -1,6 +1,7 @@
 #include "gpu_allocator.hpp"
 #include "my_vulkan/vulkan_functions.hpp"
 
+#include <algorithm>
 #include <bitset>
 
 namespace {
@@ -93,6 +94,9 @@ void GPUAllocator::BindBufferMemory(VkDevice device) {
         VK_CALL(vkBindBufferMemory(device, buffer.buffer, deviceMem, it.requiredOffset));
         buffer.deviceMemory = deviceMem;
         buffer.deviceMemoryOffset = it.requiredOffset;
+
+        void *mappedMem = mappedMemory[it.memoryTypeIndex];
+        buffer.pMappedData = (mappedMem != nullptr) ? static_cast<uint8_t*>(mappedMem) + it.requiredOffset : nullptr;
     }
 }
 
@@ -116,6 +120,10 @@ void GPUAllocator::Destroy(VkDevice device) {
 
     // Free Memory
     for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; i++) {
+        if (mappedMemory[i] != nullptr) {
+            vkUnmapMemory(device, deviceMemory[i]);
+            mappedMemory[i] = nullptr;
+        }
         vkFreeMemory(device, deviceMemory[i], nullptr);
     }
 }
@@ -181,6 +189,17 @@ Buffer& GPUAllocator::AddBuffer(VkDevice device, const CreateBufferInfo& createB
     throw std::runtime_error("GPUAllocator : Memory Type was not found");
 }
 
+VkDeviceSize GPUAllocator::GetDeviceLocalHeapSize() const {
+    VkDeviceSize heapSize = 0ULL;
+    for (uint32_t i = 0U; i < memoryProperties.memoryHeapCount; i++) {
+        if ((memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0U) {
+            heapSize = std::max(heapSize, memoryProperties.memoryHeaps[i].size);
+        }
+    }
+
+    return heapSize;
+}
+
 Image& GPUAllocator::GetImage(std::string_view const &name) {
     return *imageMapper[name.data()];
 }
@@ -208,6 +227,11 @@ void GPUAllocator::PresentResources(VkDevice device) {
             };
 
             VK_CALL(vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &deviceMemory[i]));
+
+            // Memory can be mapped only once, so all host visible buffers of the type share one mapping
+            if ((memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0U) {
+                VK_CALL(vkMapMemory(device, deviceMemory[i], 0ULL, VK_WHOLE_SIZE, 0U, &mappedMemory[i]));
+            }
         }
     }
 
@@ -59,10 +59,13 @@ public:
         VkMemoryPropertyFlags requiredMemoryFlag = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         VkMemoryPropertyFlags avoidableMemoryFlag = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
 
+    // Size of the biggest device local heap, it is used to fit big resources into the memory budget
+    VkDeviceSize GetDeviceLocalHeapSize() const;
+
     Image& GetImage(std::string_view const &name);
     Buffer& GetBuffer(std::string_view const &name);
 
-    // Bind memory with all marked objects
+    // Bind memory with all marked objects. Host visible memory is mapped persistently, see Buffer::pMappedData.
     void PresentResources(VkDevice device);
 
 private:
@@ -96,6 +99,7 @@ private:
     VkPhysicalDeviceMemoryProperties memoryProperties = {};
     VkDeviceMemory deviceMemory[VK_MAX_MEMORY_TYPES] = {};
     VkDeviceSize memorySize[VK_MAX_MEMORY_TYPES] = {};
+    void *mappedMemory[VK_MAX_MEMORY_TYPES] = {};
     bool useDeviceAddressableMemory[VK_MAX_MEMORY_TYPES] = {};
 };
 
@@ -0,0 +1,160 @@
+#include "gpu_profiler.hpp"
+#include "constants.hpp"
+#include "my_vulkan/utils.hpp"
+#include "my_vulkan/vulkan_functions.hpp"
+
+namespace KRV::Utils {
+
+GPUProfiler *GPUProfiler::activeProfiler = nullptr;
+
+void GPUProfiler::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t numOfFrames) {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0U;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilyProperties.data());
+
+    uint32_t const timestampValidBits = queueFamilyProperties[queueFamilyIndex].timestampValidBits;
+    isSupported = (timestampValidBits != 0U) && (properties.limits.timestampPeriod > 0.0F);
+    if (!isSupported) {
+        return;
+    }
+
+    timestampPeriodMs = static_cast<double>(properties.limits.timestampPeriod)*1.0e-6;
+    timestampMask = (timestampValidBits >= 64U) ? ~0ULL : ((1ULL << timestampValidBits) - 1ULL);
+
+    frameInfos.resize(numOfFrames);
+    for (uint32_t i = 0U; i < numOfFrames; i++) {
+        VkQueryPoolCreateInfo queryPoolCI {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0U,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = 2U*MAX_SCOPES,
+            .pipelineStatistics = 0U
+        };
+
+        VK_CALL(vkCreateQueryPool(device, &queryPoolCI, nullptr, &frameInfos[i].queryPool));
+        DebugUtils::Name(device, VK_OBJECT_TYPE_QUERY_POOL, frameInfos[i].queryPool, std::format("Timestamp Query Pool [{}]", i).c_str());
+
+        frameInfos[i].scopes.reserve(MAX_SCOPES);
+    }
+
+    queryResults.resize(2U*MAX_SCOPES);
+    timings.reserve(MAX_SCOPES);
+}
+
+void GPUProfiler::Destroy(VkDevice device) {
+    for (FrameInfo &frameInfo : frameInfos) {
+        vkDestroyQueryPool(device, frameInfo.queryPool, nullptr);
+    }
+    frameInfos.clear();
+
+    if (activeProfiler == this) {
+        activeProfiler = nullptr;
+    }
+}
+
+void GPUProfiler::BeginFrame(VkDevice device, VkCommandBuffer commandBuffer, uint32_t frame) {
+    if (!isSupported) {
+        return;
+    }
+
+    FrameInfo &frameInfo = frameInfos[frame];
+    ReadResults(device, frameInfo);
+
+    frameInfo.scopes.clear();
+    vkCmdResetQueryPool(commandBuffer, frameInfo.queryPool, 0U, 2U*MAX_SCOPES);
+
+    this->commandBuffer = commandBuffer;
+    this->frame = frame;
+    depth = 0U;
+    activeProfiler = this;
+}
+
+void GPUProfiler::EndFrame() {
+    commandBuffer = VK_NULL_HANDLE;
+    if (activeProfiler == this) {
+        activeProfiler = nullptr;
+    }
+}
+
+uint32_t GPUProfiler::BeginScope(char const *name) {
+    if (commandBuffer == VK_NULL_HANDLE) {
+        return INVALID_SCOPE;
+    }
+
+    FrameInfo &frameInfo = frameInfos[frame];
+    if (frameInfo.scopes.size() >= MAX_SCOPES) {
+        return INVALID_SCOPE;
+    }
+
+    uint32_t const scope = static_cast<uint32_t>(frameInfo.scopes.size());
+    frameInfo.scopes.push_back(Scope{
+        .name = name,
+        .depth = depth++,
+        .isClosed = false
+    });
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frameInfo.queryPool, 2U*scope);
+
+    return scope;
+}
+
+void GPUProfiler::EndScope(uint32_t scope) {
+    if (scope == INVALID_SCOPE || commandBuffer == VK_NULL_HANDLE) {
+        return;
+    }
+
+    FrameInfo &frameInfo = frameInfos[frame];
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frameInfo.queryPool, 2U*scope + 1U);
+
+    frameInfo.scopes[scope].isClosed = true;
+    depth--;
+}
+
+std::vector<GPUProfiler::ScopeTiming> const & GPUProfiler::GetTimings() const {
+    return timings;
+}
+
+GPUProfiler * GPUProfiler::GetActive(VkCommandBuffer commandBuffer) {
+    if (activeProfiler == nullptr || activeProfiler->commandBuffer != commandBuffer) {
+        return nullptr;
+    }
+    return activeProfiler;
+}
+
+void GPUProfiler::ReadResults(VkDevice device, FrameInfo &frameInfo) {
+    if (frameInfo.scopes.empty()) {
+        return;
+    }
+
+    // Without VK_QUERY_RESULT_WAIT_BIT: the frame is already finished, so results are available,
+    // in other case old timings are kept instead of a stall
+    uint32_t const queryCount = 2U*static_cast<uint32_t>(frameInfo.scopes.size());
+    VkResult const result = vkGetQueryPoolResults(device, frameInfo.queryPool, 0U, queryCount,
+        queryCount*sizeof(uint64_t), queryResults.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_NOT_READY) {
+        return;
+    }
+    VK_CALL(result);
+
+    timings.clear();
+    for (size_t i = 0U; i < frameInfo.scopes.size(); i++) {
+        Scope const &scope = frameInfo.scopes[i];
+        if (!scope.isClosed) {
+            continue;
+        }
+
+        uint64_t const ticks = (queryResults[2U*i + 1U] - queryResults[2U*i]) & timestampMask;
+        timings.push_back(ScopeTiming{
+            .name = scope.name,
+            .depth = scope.depth,
+            .milliseconds = static_cast<double>(ticks)*timestampPeriodMs
+        });
+    }
+}
+
+}
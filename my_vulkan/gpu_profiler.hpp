@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <string>
+#include <vector>
+
+namespace KRV::Utils {
+
+// GPU timestamp profiler, works in all builds.
+// Every frame in flight has its own query pool, results of a frame are read when its fence is already waited,
+// so reading never stalls. Scopes are opened by DebugUtils::LabelGuard, which is recorded into the active frame.
+class GPUProfiler final {
+public:
+    struct ScopeTiming final {
+        std::string name = "";
+        uint32_t depth = 0U;
+        double milliseconds = 0.0;
+    };
+
+    static constexpr uint32_t MAX_SCOPES = 32U;
+    static constexpr uint32_t INVALID_SCOPE = ~0U;
+
+    GPUProfiler() = default;
+
+    GPUProfiler(GPUProfiler const &) = delete;
+    GPUProfiler& operator=(GPUProfiler const &) = delete;
+    GPUProfiler(GPUProfiler &&) = delete;
+    GPUProfiler& operator=(GPUProfiler &&) = delete;
+
+    ~GPUProfiler() = default;
+
+    void Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex, uint32_t numOfFrames);
+    void Destroy(VkDevice device);
+
+    // Fence of the frame slot must be waited before the call.
+    // Results of the previous frame in this slot are read, then the query pool is reset in `commandBuffer`.
+    void BeginFrame(VkDevice device, VkCommandBuffer commandBuffer, uint32_t frame);
+    void EndFrame();
+
+    uint32_t BeginScope(char const *name);
+    void EndScope(uint32_t scope);
+
+    // Timings of the last completed frame in order of scope opening
+    std::vector<ScopeTiming> const & GetTimings() const;
+
+    // Profiler, which records `commandBuffer` right now, or nullptr
+    static GPUProfiler * GetActive(VkCommandBuffer commandBuffer);
+
+private:
+    struct Scope final {
+        char const *name = nullptr;
+        uint32_t depth = 0U;
+        bool isClosed = false;
+    };
+
+    struct FrameInfo final {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        std::vector<Scope> scopes{};
+    };
+
+    void ReadResults(VkDevice device, FrameInfo &frameInfo);
+
+    static GPUProfiler *activeProfiler;
+
+    bool isSupported = false;
+    double timestampPeriodMs = 0.0;
+    uint64_t timestampMask = 0ULL;
+
+    std::vector<FrameInfo> frameInfos{};
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    uint32_t frame = 0U;
+    uint32_t depth = 0U;
+
+    std::vector<uint64_t> queryResults{};
+    std::vector<ScopeTiming> timings{};
+};
+
+}
@@ -0,0 +1,118 @@
+#include "pipeline_cache.hpp"
+#include "constants.hpp"
+#include "my_vulkan/utils.hpp"
+#include "my_vulkan/vulkan_functions.hpp"
+#include "utils/hash.hpp"
+#include "utils/mapped_file.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace KRV::Utils {
+
+void PipelineCache::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t apiVersion, std::string fileName) {
+    this->fileName = std::move(fileName);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    expectedHeader.driverVersion = properties.driverVersion;
+    GetDeviceUUID(physicalDevice, apiVersion, expectedHeader.deviceUUID);
+
+    // Data is given to the driver only if it is written by the same device and driver and it isn't damaged
+    MappedFile file(this->fileName);
+    uint8_t const *pData = nullptr;
+    size_t dataSize = 0U;
+    if (file.IsOpen()) {
+        bool const isHeaderRead = (file.GetSize() >= sizeof(Header));
+        Header header{};
+        if (isHeaderRead) {
+            std::memcpy(&header, file.GetData(), sizeof(Header));
+        }
+
+        uint8_t const *pFileData = isHeaderRead ? file.GetData() + sizeof(Header) : nullptr;
+        size_t const fileDataSize = isHeaderRead ? file.GetSize() - sizeof(Header) : 0U;
+
+        // Hash is checked last, because it reads the whole file
+        char const *discardReason = nullptr;
+        if (!isHeaderRead || std::memcmp(header.magic, expectedHeader.magic, sizeof(header.magic)) != 0) {
+            discardReason = "is truncated or damaged";
+        } else if (header.version != expectedHeader.version) {
+            discardReason = "has an outdated format";
+        } else if ((header.driverVersion != expectedHeader.driverVersion) ||
+            (std::memcmp(header.deviceUUID, expectedHeader.deviceUUID, VK_UUID_SIZE) != 0)) {
+            discardReason = "belongs to another device or driver";
+        } else if ((header.dataSize != fileDataSize) || (header.dataHash != HashFNV1a(pFileData, fileDataSize))) {
+            discardReason = "is truncated or damaged";
+        }
+
+        if (discardReason == nullptr) {
+            pData = pFileData;
+            dataSize = fileDataSize;
+        } else {
+            std::cout << std::format("[PipelineCache] File {} {}, it is discarded", this->fileName, discardReason) << std::endl;
+        }
+    }
+
+    VkPipelineCacheCreateInfo pipelineCacheCI {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0U,
+        .initialDataSize = dataSize,
+        .pInitialData = pData
+    };
+
+    VK_CALL(vkCreatePipelineCache(device, &pipelineCacheCI, nullptr, &pipelineCache));
+
+    DebugUtils::Name(device, VK_OBJECT_TYPE_PIPELINE_CACHE, pipelineCache, "PipelineCache");
+}
+
+void PipelineCache::Destroy(VkDevice device) {
+    if (pipelineCache == VK_NULL_HANDLE) {
+        return;
+    }
+
+    Save(device);
+    vkDestroyPipelineCache(device, std::exchange(pipelineCache, VK_NULL_HANDLE), nullptr);
+}
+
+VkPipelineCache PipelineCache::Get() const {
+    return pipelineCache;
+}
+
+void PipelineCache::Save(VkDevice device) {
+    size_t dataSize = 0U;
+    VK_CALL(vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr));
+    std::vector<uint8_t> data(dataSize);
+    VK_CALL(vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()));
+
+    Header header = expectedHeader;
+    header.dataSize = dataSize;
+    header.dataHash = HashFNV1a(data.data(), dataSize);
+
+    // Temporary file is renamed only when it is complete, so an interrupted write never looks valid
+    std::string const tmpFileName = fileName + ".tmp";
+    std::ofstream file(tmpFileName, std::ios::binary);
+    file.write(reinterpret_cast<char const *>(&header), sizeof(Header));
+    file.write(reinterpret_cast<char const *>(data.data()), static_cast<std::streamsize>(dataSize));
+    bool const isWritten = file.good();
+    file.close();
+
+    std::error_code error{};
+    if (isWritten) {
+        std::filesystem::remove(fileName, error);
+        std::filesystem::rename(tmpFileName, fileName, error);
+    }
+
+    if (!isWritten || error) {
+        std::cerr << std::format("[PipelineCache] Cannot write file {}\n", fileName);
+        std::filesystem::remove(tmpFileName, error);
+    }
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include <string>
+
+namespace KRV::Utils {
+
+// VkPipelineCache, which is saved into a file and loaded on the next launch, so drivers don't recompile shaders.
+// The file has its own header: data of another device or driver version is discarded instead of given to the driver.
+class PipelineCache final {
+public:
+    PipelineCache() = default;
+
+    PipelineCache(PipelineCache const &) = delete;
+    PipelineCache& operator=(PipelineCache const &) = delete;
+    PipelineCache(PipelineCache &&) = delete;
+    PipelineCache& operator=(PipelineCache &&) = delete;
+
+    ~PipelineCache() = default;
+
+    // Missing or invalid file is not an error, the cache starts empty then
+    void Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t apiVersion, std::string fileName);
+    // Cache is saved before destruction
+    void Destroy(VkDevice device);
+
+    VkPipelineCache Get() const;
+
+private:
+    struct Header final {
+        char magic[8] = {'K', 'R', 'V', 'P', 'C', 'A', 'C', 'H'};
+        uint32_t version = 1U;
+        uint32_t driverVersion = 0U;
+        uint8_t deviceUUID[VK_UUID_SIZE] = {};
+        uint64_t dataSize = 0ULL;
+        uint64_t dataHash = 0ULL;
+    };
+
+    void Save(VkDevice device);
+
+    std::string fileName = "";
+    Header expectedHeader{};
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+};
+
+}
@@ -0,0 +1,158 @@
+#ifndef BLACK_HOLE_ANALYTIC_GLSL
+#define BLACK_HOLE_ANALYTIC_GLSL
+
+// Closed form of the orbit equation. In x = R*u, where R is the black hole radius,
+// (dx/dphi)^2 = x^3 - x^2 + (R/b)^2 = Q(x), so phi is an elliptic integral of x and x is an elliptic function of phi.
+// Integrals are reduced to the Legendre form (Byrd & Friedman 233.00 and 239.00) and computed in Carlson form.
+
+// Fixed numbers of iterations keep per-pixel cost constant, they are enough for FP32 even near the critical ray
+const int CARLSON_ITERATIONS = 10;
+const int AGM_ITERATIONS = 10;
+// Parameter of the critical ray is 1.0, where the integral diverges
+const float MAX_ELLIPTIC_PARAMETER = 1.0F - 1.0e-6F;
+// (R/b)^2, below which the small roots are refined
+const float NEWTON_MAX_INV_IMPACT_PARAMETER_SQUARED = 0.01F;
+// Crossings of the accretion disk plane, which are taken into account
+const uint MAX_DISK_CROSSINGS = 4U;
+
+// Carlson symmetric integral RF(x, y, z) by the duplication theorem
+float CarlsonRF(vec3 xyz) {
+    for (int i = 0; i < CARLSON_ITERATIONS; i++) {
+        vec3 s = sqrt(xyz);
+        xyz = 0.25F*(xyz + (s.x*s.y + s.x*s.z + s.y*s.z));
+    }
+
+    float mean = (xyz.x + xyz.y + xyz.z)/3.0F;
+    vec3 d = 1.0F - xyz/mean;
+    float e2 = d.x*d.y - d.z*d.z;
+    float e3 = d.x*d.y*d.z;
+    return (1.0F - e2/10.0F + e3/14.0F + e2*e2/24.0F - 3.0F*e2*e3/44.0F)/sqrt(mean);
+}
+
+// Incomplete elliptic integral of the first kind F(amplitude, m), m = k^2. Amplitude is in [0, pi).
+float EllipticF(float sinAmplitude, float cosAmplitude, float m) {
+    float f = sinAmplitude*CarlsonRF(vec3(cosAmplitude*cosAmplitude, 1.0F - m*sinAmplitude*sinAmplitude, 1.0F));
+    // F(pi - amplitude) = 2K - F(amplitude)
+    return (cosAmplitude < 0.0F) ? 2.0F*CarlsonRF(vec3(0.0F, 1.0F - m, 1.0F)) - f : f;
+}
+
+// Jacobi elliptic functions vec2(sn(w, m), cn(w, m)) by the arithmetic-geometric mean
+vec2 JacobiSnCn(float w, float m) {
+    float a = 1.0F;
+    float b = sqrt(1.0F - m);
+    float c[AGM_ITERATIONS];
+    float aValues[AGM_ITERATIONS];
+    for (int i = 0; i < AGM_ITERATIONS; i++) {
+        c[i] = 0.5F*(a - b);
+        b = sqrt(a*b);
+        a = a - c[i];
+        aValues[i] = a;
+    }
+
+    float amplitude = exp2(float(AGM_ITERATIONS))*a*w;
+    for (int i = AGM_ITERATIONS - 1; i >= 0; i--) {
+        amplitude = 0.5F*(amplitude + asin(c[i]/aValues[i]*sin(amplitude)));
+    }
+
+    return vec2(sin(amplitude), cos(amplitude));
+}
+
+// Q(x) has either three real roots r1 < 0 < r2 <= 2/3 <= r3, when b is above the critical one,
+// or one real root a < 0 and complex roots b1 +- i*a1, when b is below it.
+struct Orbit {
+    bool hasTurningPoint;
+    // vec3(r1, r2, r3) or vec3(a, A, unused), where A^2 = (b1 - a)^2 + a1^2
+    vec3 roots;
+    // phi = scale*F(amplitude(x), m) + const
+    float scale;
+    float m;
+};
+
+Orbit GetOrbit(float invImpactParameterSquared) {
+    const float criticalInvImpactParameterSquared = 4.0F/27.0F;
+    float beta2 = invImpactParameterSquared;
+
+    Orbit orbit;
+    orbit.hasTurningPoint = (beta2 < criticalInvImpactParameterSquared);
+
+    if (orbit.hasTurningPoint) {
+        // Trigonometric solution of the depressed cubic, x = 1/3 + t
+        float theta = acos(clamp(fma(-13.5F, beta2, 1.0F), -1.0F, 1.0F));
+        vec3 roots = 1.0F/3.0F + 2.0F/3.0F*cos((theta - vec3(4.0F, 2.0F, 0.0F)*pi)/3.0F);
+        // Small roots of far rays lose precision in cancellation, a Newton step restores it.
+        // Derivative of Q vanishes at the double root of the critical ray, so the step is skipped there.
+        if (beta2 < NEWTON_MAX_INV_IMPACT_PARAMETER_SQUARED) {
+            vec2 smallRoots = roots.xy;
+            roots.xy -= (smallRoots*smallRoots*(smallRoots - 1.0F) + beta2)/(smallRoots*(3.0F*smallRoots - 2.0F));
+        }
+
+        orbit.roots = roots;
+        orbit.scale = 2.0F/sqrt(roots.z - roots.x);
+        orbit.m = (roots.y - roots.x)/(roots.z - roots.x);
+    } else {
+        // Hyperbolic solution of the depressed cubic, the sum of roots is 1.0 and their product is -beta2
+        float a = 1.0F/3.0F - 2.0F/3.0F*cosh(acosh(13.5F*beta2 - 1.0F)/3.0F);
+        float b1 = 0.5F*(1.0F - a);
+        float A = sqrt(a*a - 2.0F*a*b1 - beta2/a);
+
+        orbit.roots = vec3(a, A, 0.0F);
+        orbit.scale = 1.0F/sqrt(A);
+        orbit.m = (A + b1 - a)/(2.0F*A);
+    }
+
+    orbit.m = min(orbit.m, MAX_ELLIPTIC_PARAMETER);
+    return orbit;
+}
+
+// Orbital angle of x up to a constant, it increases with x up to the turning point or to the horizon
+float OrbitPhi(Orbit orbit, float x) {
+    if (orbit.hasTurningPoint) {
+        float sin2 = clamp((x - orbit.roots.x)/(orbit.roots.y - orbit.roots.x), 0.0F, 1.0F);
+        return orbit.scale*EllipticF(sqrt(sin2), sqrt(1.0F - sin2), orbit.m);
+    }
+
+    float a = orbit.roots.x;
+    float A = orbit.roots.y;
+    float cosAmplitude = (A - x + a)/(A + x - a);
+    return orbit.scale*EllipticF(sqrt(max(1.0F - cosAmplitude*cosAmplitude, 0.0F)), cosAmplitude, orbit.m);
+}
+
+// Inverse of OrbitPhi. It goes through the turning point, so x of both branches is given by the same phi.
+float OrbitX(Orbit orbit, float phi) {
+    vec2 snCn = JacobiSnCn(phi/orbit.scale, orbit.m);
+
+    if (orbit.hasTurningPoint) {
+        return fma(orbit.roots.y - orbit.roots.x, snCn.x*snCn.x, orbit.roots.x);
+    }
+
+    return fma(orbit.roots.y, (1.0F - snCn.y)/(1.0F + snCn.y), orbit.roots.x);
+}
+
+// Half period of OrbitPhi, it is phi of the turning point
+float OrbitTurningPhi(Orbit orbit) {
+    return orbit.scale*CarlsonRF(vec3(0.0F, 1.0F - orbit.m, 1.0F));
+}
+
+// Orbital angle, which is swept from x up to the infinity or the horizon, dx = dx/dphi.
+// x grows along ingoing rays, startPhi is OrbitPhi of x.
+float OrbitSweep(float x, float dx, out Orbit orbit, out float startPhi, out bool isCaptured) {
+    orbit = GetOrbit(fma(x*x, -x, fma(x, x, dx*dx)));
+    startPhi = OrbitPhi(orbit, x);
+    bool isIngoing = (dx > 0.0F);
+
+    if (orbit.hasTurningPoint) {
+        // Case: Fall into black hole from the photon sphere, there is no accretion disk inside of it
+        isCaptured = (x > 2.0F/3.0F);
+        if (isCaptured) {
+            return 0.0F;
+        }
+        // Ingoing ray passes the turning point, the orbit is symmetric around it
+        float endPhi = isIngoing ? 2.0F*OrbitTurningPhi(orbit) - OrbitPhi(orbit, 0.0F) : OrbitPhi(orbit, 0.0F);
+        return abs(endPhi - startPhi);
+    }
+
+    isCaptured = isIngoing;
+    return abs(OrbitPhi(orbit, isCaptured ? 1.0F : 0.0F) - startPhi);
+}
+
+#endif // BLACK_HOLE_ANALYTIC_GLSL
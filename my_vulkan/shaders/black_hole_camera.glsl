@@ -0,0 +1,41 @@
+#ifndef BLACK_HOLE_CAMERA_GLSL
+#define BLACK_HOLE_CAMERA_GLSL
+
+// Camera params
+const float HALF_FOV_HORIZONTAL_TAN = tan(radians(60));
+
+// Axes of the image plane, they are scaled by field of view
+struct CameraBasis {
+    vec3 forward;
+    vec3 horizontal;
+    vec3 vertical;
+};
+
+CameraBasis GetCameraBasis(vec3 cameraDir, vec2 resolution) {
+    const float horizontalScale = HALF_FOV_HORIZONTAL_TAN;
+    float verticalScale = (resolution.y/resolution.x)*HALF_FOV_HORIZONTAL_TAN;
+
+    CameraBasis basis;
+    basis.forward = cameraDir;
+    basis.horizontal = horizontalScale*normalize(vec3(cameraDir.y, -cameraDir.x, 0.0));
+    basis.vertical = verticalScale*normalize(cross(cameraDir, basis.horizontal));
+    return basis;
+}
+
+// Give cameraDir of the pixel center
+vec3 PixelDirection(CameraBasis basis, vec2 pixel, vec2 resolution) {
+    vec2 uv = (pixel + 0.5F)/resolution;
+    vec2 xy = fma(uv, vec2(2.0F), vec2(-1.0F));
+    return basis.forward + basis.horizontal*xy.x + basis.vertical*xy.y;
+}
+
+// Inverse of PixelDirection: vec3(uv, depth), the direction is behind the camera if depth isn't positive
+vec3 DirectionUV(CameraBasis basis, vec3 direction) {
+    float depth = dot(direction, basis.forward)/dot(basis.forward, basis.forward);
+    vec3 planeDirection = direction/depth - basis.forward;
+    vec2 xy = vec2(dot(planeDirection, basis.horizontal)/dot(basis.horizontal, basis.horizontal),
+        dot(planeDirection, basis.vertical)/dot(basis.vertical, basis.vertical));
+    return vec3(fma(xy, vec2(0.5F), vec2(0.5F)), depth);
+}
+
+#endif // BLACK_HOLE_CAMERA_GLSL
@@ -0,0 +1,53 @@
+#ifndef BLACK_HOLE_INTERLEAVE_GLSL
+#define BLACK_HOLE_INTERLEAVE_GLSL
+
+#include "black_hole.in"
+
+// Only 1 of factor pixels is ray marched per frame, the rest are reprojected from the previous frame.
+// Factor is 1, 2 (checkerboard) or 4 (one pixel of 2x2 block), both factor and phase are 8 bits of frameInfo.
+
+// Traced pixel of 2x2 block per phase, every pixel is traced once per 4 frames
+const ivec2 INTERLEAVE_BLOCK_OFFSETS[4] = ivec2[4](ivec2(0, 0), ivec2(1, 1), ivec2(1, 0), ivec2(0, 1));
+
+uint InterleaveFactor(uint frameInfo) {
+    return (frameInfo >> FRAME_INFO_INTERLEAVE_FACTOR_SHIFT) & 0xFFU;
+}
+
+int InterleavePhase(uint frameInfo) {
+    return int((frameInfo >> FRAME_INFO_INTERLEAVE_PHASE_SHIFT) & 0xFFU);
+}
+
+// Extent of traced pixels, it is the extent of the compacted dispatch
+uvec2 TracedExtent(uvec2 renderExtent, uint frameInfo) {
+    uint factor = InterleaveFactor(frameInfo);
+    return uvec2(renderExtent.x/(factor > 1U ? 2U : 1U), renderExtent.y/(factor > 2U ? 2U : 1U));
+}
+
+// Dispatch is compacted, so all invocations of a subgroup trace rays and none of them idles
+ivec2 TracedPixel(ivec2 id, uint frameInfo) {
+    uint factor = InterleaveFactor(frameInfo);
+    int phase = InterleavePhase(frameInfo);
+
+    if (factor == 2U) {
+        return ivec2(2*id.x + ((id.y + phase) & 1), id.y);
+    } else if (factor == 4U) {
+        return 2*id + INTERLEAVE_BLOCK_OFFSETS[phase & 3];
+    }
+
+    return id;
+}
+
+bool IsTracedPixel(ivec2 pixel, uint frameInfo) {
+    uint factor = InterleaveFactor(frameInfo);
+    int phase = InterleavePhase(frameInfo);
+
+    if (factor == 2U) {
+        return ((pixel.x + pixel.y + phase) & 1) == 0;
+    } else if (factor == 4U) {
+        return all(equal(pixel & 1, INTERLEAVE_BLOCK_OFFSETS[phase & 3]));
+    }
+
+    return true;
+}
+
+#endif // BLACK_HOLE_INTERLEAVE_GLSL
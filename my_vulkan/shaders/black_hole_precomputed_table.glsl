@@ -0,0 +1,124 @@
+#include "black_hole.in"
+#include "black_hole_specialization.glsl"
+
+// Storage of precomputed tables. It is selected by PRECOMPUTED_TABLE_FORMAT and PRECOMPUTED_TABLE_PACKED CMake options.
+// Decoded values don't depend on the storage format, so only writers know it.
+// Packed layout: phi table is a scratch image and the accretion disk table is vec4(radii, phi, flag).
+
+#if defined(PRECOMPUTED_TABLE_UNORM16)
+#define PRECOMPUTED_TABLE_FORMAT_RG rg16
+#define PRECOMPUTED_TABLE_FORMAT_RGBA rgba16
+// value = fma(texel, scale, bias)
+const vec2 PHI_DECODE_SCALE = vec2(PRECOMPUTED_PHI_RANGE, 2.0F);
+const vec2 PHI_DECODE_BIAS = vec2(0.0F, -1.0F);
+// Range follows the black hole radius, which is a specialization constant
+#define RADII_DECODE_SCALE vec2(PRECOMPUTED_RADIUS_RANGE)
+#elif defined(PRECOMPUTED_TABLE_FLOAT16)
+#define PRECOMPUTED_TABLE_FORMAT_RG rg16f
+#define PRECOMPUTED_TABLE_FORMAT_RGBA rgba16f
+const vec2 PHI_DECODE_SCALE = vec2(1.0F);
+const vec2 PHI_DECODE_BIAS = vec2(0.0F);
+#define RADII_DECODE_SCALE vec2(1.0F)
+#else // defined(PRECOMPUTED_TABLE_FLOAT32)
+#define PRECOMPUTED_TABLE_FORMAT_RG rg32f
+#define PRECOMPUTED_TABLE_FORMAT_RGBA rgba32f
+const vec2 PHI_DECODE_SCALE = vec2(1.0F);
+const vec2 PHI_DECODE_BIAS = vec2(0.0F);
+#define RADII_DECODE_SCALE vec2(1.0F)
+#endif // PRECOMPUTED_TABLE_UNORM16, PRECOMPUTED_TABLE_FLOAT16, PRECOMPUTED_TABLE_FLOAT32
+
+#ifdef PRECOMPUTED_TABLE_PACKED
+#define PRECOMPUTED_PHI_TEXTURE_FORMAT rg32f
+#define PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_FORMAT PRECOMPUTED_TABLE_FORMAT_RGBA
+#else
+#define PRECOMPUTED_PHI_TEXTURE_FORMAT PRECOMPUTED_TABLE_FORMAT_RG
+#define PRECOMPUTED_ACCR_DISK_DATA_TEXTURE_FORMAT PRECOMPUTED_TABLE_FORMAT_RG
+#endif // PRECOMPUTED_TABLE_PACKED
+
+// phiAndFlag = vec2(phi, 1.0 if the ray goes into infinity or -1.0 if it falls into black hole)
+vec2 DecodePhi(vec2 texel) {
+    return fma(texel, PHI_DECODE_SCALE, PHI_DECODE_BIAS);
+}
+
+// Radii of the first and the second intersections with the accretion disk plane
+vec2 DecodeRadii(vec2 texel) {
+    return texel*RADII_DECODE_SCALE;
+}
+
+// Tables are parameterized by x = u*BLACK_HOLE_RADIUS and angle = atan(-(du/dphi)/u)/pi + 0.5, both in [0.0, 1.0].
+// Deflection diverges at the critical angle, so the angle axis is warped around it: s = sign(t)*|t|^POWER,
+// where t in [-1.0, 1.0] is the texture coordinate relative to the critical angle.
+
+// Critical ray has impact parameter sqrt(27)/2, so (du/dphi)^2 = 4/27 - x^2 + x^3 in black hole radii.
+// It goes inwards outside the photon sphere (x < 2/3) and outwards inside it.
+float CriticalAngle(float x) {
+    float criticalDerivative = sign(2.0F/3.0F - x)*sqrt(max(fma(x*x, x - 1.0F, 4.0F/27.0F), 0.0F));
+    return fma(atan(-criticalDerivative/x), 0.318309886183790671538F, 0.5F);
+}
+
+// Texture coordinate of the angle axis into angle, it is used by writers
+float AngleFromTexCoord(float x, float texCoord) {
+    float criticalAngle = CriticalAngle(x);
+    float s = fma(texCoord, 2.0F, -1.0F);
+    s = sign(s)*pow(abs(s), PRECOMPUTED_ANGLE_WARP_POWER);
+    return criticalAngle + s*((s < 0.0F) ? criticalAngle : (1.0F - criticalAngle));
+}
+
+// Angle into texture coordinate of the angle axis, it is used by readers
+float TexCoordFromAngle(float x, float angle) {
+    float criticalAngle = CriticalAngle(x);
+    float s = (angle - criticalAngle)/((angle < criticalAngle) ? criticalAngle : (1.0F - criticalAngle));
+    return fma(sign(s), 0.5F*pow(abs(s), 1.0F/PRECOMPUTED_ANGLE_WARP_POWER), 0.5F);
+}
+
+#ifdef PRECOMPUTE_TABLE
+
+// Tables are generated by slices over frames, a slice is a band of rows or layers of a table
+layout(push_constant) uniform PushConst {
+    // Texel of the first invocation
+    uvec3 sliceOffset;
+    // Rows of the slice, the dispatch may overlap them
+    uint sliceRows;
+};
+
+// Maximal errors of stored values against FP32 ones, they are float bits.
+// Comparison of positive float bits as uint is the same as comparison of floats.
+layout(std430, set = 0, binding = BINDING_PRECOMPUTED_TABLE_ERROR_BUFFER) restrict buffer PrecomputedTableError {
+    uint maxPhiError;
+    uint maxRadiusError;
+};
+
+// Same rounding as the storage format does
+vec2 Quantize(vec2 texel) {
+#if defined(PRECOMPUTED_TABLE_UNORM16)
+    return unpackUnorm2x16(packUnorm2x16(texel));
+#elif defined(PRECOMPUTED_TABLE_FLOAT16)
+    return unpackHalf2x16(packHalf2x16(texel));
+#else
+    return texel;
+#endif // PRECOMPUTED_TABLE_UNORM16, PRECOMPUTED_TABLE_FLOAT16
+}
+
+vec2 EncodePhi(vec2 phiAndFlag) {
+    vec2 texel = (phiAndFlag - PHI_DECODE_BIAS)/PHI_DECODE_SCALE;
+
+    // Direction matters only for rays, which go into infinity
+    if (phiAndFlag.y > 0.0F) {
+        atomicMax(maxPhiError, floatBitsToUint(abs(DecodePhi(Quantize(texel)).x - phiAndFlag.x)));
+    }
+
+    return texel;
+}
+
+vec2 EncodeRadii(vec2 radii) {
+    vec2 texel = radii/RADII_DECODE_SCALE;
+
+    // Out of range radii are far from the accretion disk, their error doesn't matter
+    vec2 radiiError = abs(DecodeRadii(Quantize(texel)) - radii);
+    radiiError = mix(radiiError, vec2(0.0F), greaterThan(radii, vec2(PRECOMPUTED_RADIUS_RANGE)));
+    atomicMax(maxRadiusError, floatBitsToUint(max(radiiError.x, radiiError.y)));
+
+    return texel;
+}
+
+#endif // PRECOMPUTE_TABLE
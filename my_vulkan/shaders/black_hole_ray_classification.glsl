@@ -0,0 +1,77 @@
+#ifndef BLACK_HOLE_RAY_CLASSIFICATION_GLSL
+#define BLACK_HOLE_RAY_CLASSIFICATION_GLSL
+
+// Rays are classified by the conserved impact parameter b before marching, R is the black hole radius:
+// (du/dphi)^2 = 1/b^2 - u^2 + R*u^3.
+// Far escaping rays are deflected analytically and captured rays, which can't reach the accretion disk, are black.
+// Only rays near the critical impact parameter are marched.
+
+#define INV_PHOTON_SPHERE_RADIUS (2.0F/(3.0F*BLACK_HOLE_RADIUS))
+#define INV_INNER_RADIUS_OF_ACCRETION_DISK (1.0F/INNER_RADIUS_OF_ACCRETION_DISK)
+// 1/b^2 of the critical ray, which winds around the photon sphere
+#define CRITICAL_INV_IMPACT_PARAMETER_SQUARED (4.0F/(27.0F*BLACK_HOLE_RADIUS*BLACK_HOLE_RADIUS))
+// Error of the first order deflection is 15*pi/16*(R/b)^2, it is 7e-4 rad at 64 R, a quarter of a pixel.
+// Outer radius D of the accretion disk is a specialization constant, so the threshold is also kept beyond it:
+// the closest approach of the ray is outside of the disk if b > D/sqrt(1 - R/D).
+#define WEAK_FIELD_IMPACT_PARAMETER (max(64.0F*BLACK_HOLE_RADIUS, \
+    OUTER_RADIUS_OF_ACCRETION_DISK*inversesqrt(1.0F - BLACK_HOLE_RADIUS/OUTER_RADIUS_OF_ACCRETION_DISK)))
+
+// Escape angle of a weakly deflected ray. First order solution of u'' + u = 1.5*R*u^2 with initial uInfo is
+// u = sin(phi + alpha)/b + R/(2*b^2)*(1 + cos(phi + alpha)^2) + homogeneous terms, where tan(alpha) = u/(du/dphi).
+// Its root is pi - alpha + R/(2*b)*(2 + 3*cos(alpha) - cos(alpha)^3).
+float WeakDeflectionEscapePhi(vec2 uInfo) {
+    float invB = length(uInfo);
+    float cosAlpha = uInfo.y/invB;
+    return pi - atan(uInfo.x, uInfo.y) + 0.5F*BLACK_HOLE_RADIUS*invB*fma(cosAlpha, 3.0F - cosAlpha*cosAlpha, 2.0F);
+}
+
+// Upper bound of phi, which is swept by a captured ray from u to the inner radius of the accretion disk.
+// Below the critical impact parameter (du/dphi)^2 >= R*(u - 2/(3R))^2*(u + 1/(3R)),
+// and the integral of its inverse square root is 2*atanh(sqrt(R*u + 1/3)).
+float CapturedSweepBound(float u) {
+    float innerSweep = 2.0F*atanh(sqrt(BLACK_HOLE_RADIUS*INV_INNER_RADIUS_OF_ACCRETION_DISK + 1.0F/3.0F));
+    return innerSweep - 2.0F*atanh(sqrt(fma(u, BLACK_HOLE_RADIUS, 1.0F/3.0F)));
+}
+
+// Return value is true if the color of the ray is known without marching.
+// Captured rays, which are still marched, stop at invCaptureRadius instead of the horizon.
+// Weakly deflected rays keep the spread angle of the pixel footprint.
+bool ClassifyRay(vec2 uInfo, vec3 rotationAxis, float pixelSpread, out vec3 outputColor, out float invCaptureRadius) {
+    outputColor = vec3(0.0F);
+    invCaptureRadius = INV_BLACK_HOLE_RADIUS;
+
+    vec3 position;
+    vec3 direction;
+
+    // Case: Escape with weak deflection, the ray is far from the accretion disk
+    if (length(uInfo) < 1.0F/WEAK_FIELD_IMPACT_PARAMETER) {
+        transformUInfoIntoDirectionAndPosition(uInfo, WeakDeflectionEscapePhi(uInfo), rotationAxis, position, direction);
+        outputColor = sampleSky(position, pixelSpread);
+        return true;
+    }
+
+    // Ingoing ray without a turning point: inside of the photon sphere or below the critical impact parameter
+    float invImpactParameterSquared = fma(-BLACK_HOLE_RADIUS*uInfo.x, uInfo.x*uInfo.x, dot(uInfo, uInfo));
+    bool isCaptured = (uInfo.y > 0.0F) &&
+        (uInfo.x > INV_PHOTON_SPHERE_RADIUS || invImpactParameterSquared > CRITICAL_INV_IMPACT_PARAMETER_SQUARED);
+    if (!isCaptured) {
+        return false;
+    }
+
+    // Radius only decreases, so nothing is emitted inside of the inner radius of the accretion disk
+    invCaptureRadius = INV_INNER_RADIUS_OF_ACCRETION_DISK;
+    if (uInfo.x > INV_INNER_RADIUS_OF_ACCRETION_DISK) {
+        return true;
+    }
+
+    // Case: Fall into black hole without crossing the accretion disk.
+    // Up to the inner radius phi stays in [0, bound], bound < pi, so the height above the disk plane changes sign
+    // at most once there and its minimal magnitude is at the ends.
+    transformUInfoIntoDirectionAndPosition(uInfo, CapturedSweepBound(uInfo.x), rotationAxis, position, direction);
+    float startHeight = dot(normalize(cameraPos), ROTATION_AXIS_OF_ACCRETION_DISK);
+    float endHeight = dot(normalize(position), ROTATION_AXIS_OF_ACCRETION_DISK);
+    return (startHeight*endHeight > 0.0F) &&
+        (min(abs(startHeight), abs(endHeight))*INNER_RADIUS_OF_ACCRETION_DISK > THICKNESS_OF_ACCRETION_DISK);
+}
+
+#endif // BLACK_HOLE_RAY_CLASSIFICATION_GLSL
@@ -0,0 +1,86 @@
+#ifndef BLACK_HOLE_RAY_CONE_GLSL
+#define BLACK_HOLE_RAY_CONE_GLSL
+
+#include "black_hole.in"
+#include "black_hole_specialization.glsl"
+
+// Footprint of a pixel is a ray cone: its width at a position of the ray and its spread angle.
+// Both are followed by the neighbouring rays of the pixel, and the mip level of a texture is picked by them.
+// In the orbit plane the neighbouring ray differs by the angle alpha between the ray and the camera position at the start.
+// Variation = d(uInfo)/d(alpha) follows the linearized orbit equation: variation'' = (3*R*u - 1)*variation.
+// Across the orbit plane the neighbouring ray is in the plane rotated around the camera position
+// by (angle between pixels)/sin(alpha), and it is exact because of the spherical symmetry.
+
+// Mean angle of a texel of a cube map face is pi/2 divided by the face size
+const float CUBE_MAP_TEXELS_PER_RADIAN_SCALE = 0.636619772367581343076F; // 2/pi
+
+// Limit of half floats of the saved variation, bigger ones give the last level anyway
+const float MAX_SAVED_VARIATION = 60000.0F;
+
+// u = 1/r; r - radius
+// uInfo = vec2(u, d(u)/d(phi));
+// d(uInfo)/d(alpha) at the camera, there d(u)/d(phi) = -u*cot(alpha)
+vec2 InitialVariation(vec2 uInfo) {
+    return vec2(0.0F, dot(uInfo, uInfo)/uInfo.x);
+}
+
+// Midpoint step of the linearized orbit equation along the step of the ray from oldUInfo to newUInfo
+vec2 PropagateVariation(vec2 variation, vec2 oldUInfo, vec2 newUInfo, float h) {
+    float gain = fma(1.5F*BLACK_HOLE_RADIUS, oldUInfo.x + newUInfo.x, -1.0F);
+    vec2 midVariation = variation + 0.5F*h*vec2(variation.y, gain*variation.x);
+    return variation + h*vec2(midVariation.y, gain*midVariation.x);
+}
+
+// Variation is saved between passes of wavefront ray marching in half floats
+uint PackVariation(vec2 variation) {
+    float magnitude = max(abs(variation.x), abs(variation.y));
+    return packHalf2x16(variation*min(MAX_SAVED_VARIATION/max(magnitude, 1.0e-30F), 1.0F));
+}
+
+vec2 UnpackVariation(uint packedVariation) {
+    return unpackHalf2x16(packedVariation);
+}
+
+// sin(alpha) of the start of the ray, 1/b^2 = (du/dphi)^2 + u^2 - R*u^3 is conserved
+float InitialSinAlpha(vec2 uInfo, float invCameraDistance) {
+    float invImpactParameterSquared = fma(-BLACK_HOLE_RADIUS*uInfo.x, uInfo.x*uInfo.x, dot(uInfo, uInfo));
+    float invStartLengthSquared = fma(BLACK_HOLE_RADIUS*invCameraDistance, invCameraDistance*invCameraDistance,
+        invImpactParameterSquared);
+    return invCameraDistance*inversesqrt(invStartLengthSquared);
+}
+
+// uInfo of the neighbouring ray in the orbit plane. It is rotated by delta towards the bigger impact parameter
+// b = r*sin(alpha), so it escapes if the ray escapes. Ingoing rays have alpha above pi/2.
+vec2 NeighbourUInfo(vec2 uInfo, float delta) {
+    float alpha = atan(uInfo.x, -uInfo.y);
+    alpha += (uInfo.y > 0.0F) ? -delta : delta;
+    return vec2(uInfo.x, -uInfo.x/tan(alpha));
+}
+
+// vec2(width, spread angle) of the cone per unit of the angle between pixels.
+// position and direction are the ones of the ray, sinAlpha is InitialSinAlpha.
+vec2 RayConeGain(vec2 uInfo, vec2 variation, vec3 position, vec3 direction, vec3 normCameraPos, float sinAlpha) {
+    // Distance to the neighbouring ray across the direction and the angle between directions
+    float uLength = length(uInfo);
+    vec2 inPlane = vec2(abs(variation.x/uInfo.x)/uLength, abs(uInfo.x*variation.y - uInfo.y*variation.x)/(uLength*uLength));
+    vec2 acrossPlane = vec2(length(cross(normCameraPos, position)), length(cross(normCameraPos, direction)))/max(sinAlpha, 1.0e-4F);
+    return max(inPlane, acrossPlane);
+}
+
+// Mip level of a cube map with the face size for the spread angle
+float CubeMapLod(float spread, float faceSize) {
+    return log2(spread*faceSize*CUBE_MAP_TEXELS_PER_RADIAN_SCALE);
+}
+
+// Ray cone mip level of a triangle texture (Akenine-Moller et al., Texture Level of Detail Strategies
+// for Real-Time Ray Tracing): texel to world area ratio of the triangle and the cone width, which is
+// stretched by the grazing angle. Edges are given in world space and in texture coordinates.
+float TriangleTextureLod(vec3 edge1, vec3 edge2, vec2 texEdge1, vec2 texEdge2, vec2 textureSize, vec3 direction, float width) {
+    vec3 normal = cross(edge1, edge2);
+    float worldArea = max(length(normal), 1.0e-20F);
+    float texelArea = max(abs(texEdge1.x*texEdge2.y - texEdge1.y*texEdge2.x)*textureSize.x*textureSize.y, 1.0e-20F);
+    float cosine = abs(dot(normal, normalize(direction)))/worldArea;
+    return 0.5F*log2(texelArea/worldArea) + log2(width/max(cosine, 0.01F));
+}
+
+#endif // BLACK_HOLE_RAY_CONE_GLSL
@@ -0,0 +1,26 @@
+#ifndef BLACK_HOLE_REFINEMENT_GLSL
+#define BLACK_HOLE_REFINEMENT_GLSL
+
+#include "black_hole.in"
+
+// Progressive refinement of the static camera image.
+// Sample 0 is the usual frame, samples from 1 are jittered inside of the pixel and accumulated with finer steps.
+
+uint RefinementSample(uint frameInfo) {
+    return frameInfo >> FRAME_INFO_REFINEMENT_SAMPLE_SHIFT;
+}
+
+// Offset of the ray from the pixel center, R2 low discrepancy sequence
+vec2 RefinementJitter(uint refinementSample) {
+    if (refinementSample == 0U) {
+        return vec2(0.0F);
+    }
+    return fract(fma(vec2(float(refinementSample)), vec2(0.754877666F, 0.569840291F), vec2(0.5F))) - 0.5F;
+}
+
+// Integration step multiplier: 1, 1/2 or 1/4
+float RefinementStepScale(uint refinementSample) {
+    return 1.0F/float(1U << min(refinementSample/REFINEMENT_SAMPLES_PER_STEP_LEVEL, 2U));
+}
+
+#endif // BLACK_HOLE_REFINEMENT_GLSL
@@ -29,4 +29,48 @@ vec2 rk(vec2 uInfo, float h) {
     return uInfo + h*f(uInfo);
 #endif // RUNGE_KUTTE_1
 
-}
\ No newline at end of file
+}
+
+#ifdef RUNGE_KUTTE_45
+
+// Dormand-Prince embedded RK5(4) pair with adaptive step size.
+// k1 is f(uInfo), it is replaced with f(new uInfo) on accepted step (First Same As Last).
+// h is replaced with the next proposed step in [hMin, hMax], it is hMin if the error is not a number.
+// Forced step is accepted whatever its error, the caller limits the number of rejected ones.
+// Return value is the size of the accepted step, or zero if the step is rejected.
+// u = 1/r; r - radius
+// uInfo = vec2(u, d(u)/d(phi));
+float rkAdaptive(inout vec2 uInfo, inout vec2 k1, inout float h, float tolerance, float hMin, float hMax, bool isForced) {
+    vec2 k2 = f(uInfo + h*(0.2F*k1));
+    vec2 k3 = f(uInfo + h*(0.075F*k1 + 0.225F*k2));
+    vec2 k4 = f(uInfo + h*((44.0F/45.0F)*k1 - (56.0F/15.0F)*k2 + (32.0F/9.0F)*k3));
+    vec2 k5 = f(uInfo + h*((19372.0F/6561.0F)*k1 - (25360.0F/2187.0F)*k2 + (64448.0F/6561.0F)*k3 -
+        (212.0F/729.0F)*k4));
+    vec2 k6 = f(uInfo + h*((9017.0F/3168.0F)*k1 - (355.0F/33.0F)*k2 + (46732.0F/5247.0F)*k3 +
+        (49.0F/176.0F)*k4 - (5103.0F/18656.0F)*k5));
+    vec2 newUInfo = uInfo + h*((35.0F/384.0F)*k1 + (500.0F/1113.0F)*k3 + (125.0F/192.0F)*k4 -
+        (2187.0F/6784.0F)*k5 + (11.0F/84.0F)*k6);
+    vec2 k7 = f(newUInfo);
+
+    // Difference between 5th and 4th order solutions
+    vec2 error = h*((71.0F/57600.0F)*k1 - (71.0F/16695.0F)*k3 + (71.0F/1920.0F)*k4 -
+        (17253.0F/339200.0F)*k5 + (22.0F/525.0F)*k6 - (1.0F/40.0F)*k7);
+
+    // Mixed absolute and relative tolerance
+    vec2 scale = tolerance*(vec2(1.0F) + max(abs(uInfo), abs(newUInfo)));
+    vec2 scaledError = abs(error)/scale;
+    float errorNorm = max(scaledError.x, scaledError.y);
+
+    float stepSize = 0.0F;
+    if (errorNorm <= 1.0F || isForced) {
+        stepSize = h;
+        uInfo = newUInfo;
+        k1 = k7;
+    }
+
+    // clamp, max and pow are undefined for NaN
+    h = isnan(errorNorm) ? hMin : clamp(h*clamp(0.9F*pow(max(errorNorm, 1.0e-10F), -0.2F), 0.2F, 5.0F), hMin, hMax);
+    return stepSize;
+}
+
+#endif // RUNGE_KUTTE_45
@@ -0,0 +1,30 @@
+#ifndef BLACK_HOLE_SPECIALIZATION_GLSL
+#define BLACK_HOLE_SPECIALIZATION_GLSL
+
+#include "black_hole.in"
+
+// Tuning parameters are specialization constants, so they are retuned per pipeline without a shader rebuild.
+// Float expressions of them aren't specialization constants themselves, so derived values are macros.
+
+layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y, local_size_z = 1U) in;
+layout(local_size_x_id = SPECIALIZATION_ID_LOCAL_SIZE_X, local_size_y_id = SPECIALIZATION_ID_LOCAL_SIZE_Y) in;
+
+// Black hole center is (0.0, 0.0, 0.0)
+layout(constant_id = SPECIALIZATION_ID_BLACK_HOLE_RADIUS) const float BLACK_HOLE_RADIUS = DEFAULT_BLACK_HOLE_RADIUS;
+#define INV_BLACK_HOLE_RADIUS (1.0F/BLACK_HOLE_RADIUS)
+
+layout(constant_id = SPECIALIZATION_ID_MAX_STEPS) const uint MAX_STEPS = DEFAULT_MAX_STEPS;
+layout(constant_id = SPECIALIZATION_ID_STEP) const float h = DEFAULT_STEP;
+layout(constant_id = SPECIALIZATION_ID_TAN_STOP_ITER) const float TAN_STOP_ITER = DEFAULT_TAN_STOP_ITER;
+
+layout(constant_id = SPECIALIZATION_ID_PRECOMPUTE_MAX_STEPS) const uint PRECOMPUTE_MAX_STEPS = DEFAULT_PRECOMPUTE_MAX_STEPS;
+layout(constant_id = SPECIALIZATION_ID_PRECOMPUTE_STEP) const float PRECOMPUTE_STEP = DEFAULT_PRECOMPUTE_STEP;
+layout(constant_id = SPECIALIZATION_ID_PRECOMPUTE_TAN_STOP_ITER) const float PRECOMPUTE_TAN_STOP_ITER = DEFAULT_PRECOMPUTE_TAN_STOP_ITER;
+
+// Radii of the accretion disk in black hole radii
+layout(constant_id = SPECIALIZATION_ID_INNER_RADIUS_OF_ACCRETION_DISK) const float INNER_RADIUS_OF_ACCRETION_DISK_IN_RADII = DEFAULT_INNER_RADIUS_OF_ACCRETION_DISK;
+layout(constant_id = SPECIALIZATION_ID_OUTER_RADIUS_OF_ACCRETION_DISK) const float OUTER_RADIUS_OF_ACCRETION_DISK_IN_RADII = DEFAULT_OUTER_RADIUS_OF_ACCRETION_DISK;
+#define INNER_RADIUS_OF_ACCRETION_DISK (INNER_RADIUS_OF_ACCRETION_DISK_IN_RADII*BLACK_HOLE_RADIUS)
+#define OUTER_RADIUS_OF_ACCRETION_DISK (OUTER_RADIUS_OF_ACCRETION_DISK_IN_RADII*BLACK_HOLE_RADIUS)
+
+#endif // BLACK_HOLE_SPECIALIZATION_GLSL
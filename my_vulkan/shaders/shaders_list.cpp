@@ -17,6 +17,10 @@ const std::unordered_map<SHADER_LIST_ID, std::vector<uint32_t>> shaderList = {
         SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK1_COMP,
         #include <black_hole_ray_marching_rk1.comp.spv>
     },
+    {
+        SHADER_LIST_ID::BLACK_HOLE_RAY_MARCHING_RK45_COMP,
+        #include <black_hole_ray_marching_rk45.comp.spv>
+    },
     {
         SHADER_LIST_ID::BLACK_HOLE_RAY_QUERY_COMP,
         #include <black_hole_ray_query.comp.spv>
@@ -25,6 +29,10 @@ const std::unordered_map<SHADER_LIST_ID, std::vector<uint32_t>> shaderList = {
         SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTED_COMP,
         #include <black_hole_precomputed.comp.spv>
     },
+    {
+        SHADER_LIST_ID::BLACK_HOLE_ANALYTIC_COMP,
+        #include <black_hole_analytic.comp.spv>
+    },
     {
         SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_PHI_TEXTURE_COMP,
         #include <black_hole_precompute_phi_texture.comp.spv>
@@ -32,11 +40,19 @@ const std::unordered_map<SHADER_LIST_ID, std::vector<uint32_t>> shaderList = {
     {
         SHADER_LIST_ID::BLACK_HOLE_PRECOMPUTE_ACCR_DISK_DATA_TEXTURE_COMP,
         #include <black_hole_precompute_accr_disk_data_texture.comp.spv>
+    },
+    {
+        SHADER_LIST_ID::BLACK_HOLE_RECONSTRUCT_COMP,
+        #include <black_hole_reconstruct.comp.spv>
     }
 };
 
+std::vector<uint32_t> const & GetShaderCode(SHADER_LIST_ID id) {
+    return shaderList.at(id);
+}
+
 ShaderModule::ShaderModule(VkDevice device, SHADER_LIST_ID id) : device(device) {
-    auto const &shaderData = shaderList.at(id);
+    auto const &shaderData = GetShaderCode(id);
 
     VkShaderModuleCreateInfo const shaderModuleCreateInfo {
         .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
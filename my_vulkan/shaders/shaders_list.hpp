@@ -10,12 +10,18 @@ enum class SHADER_LIST_ID {
     BLACK_HOLE_RAY_MARCHING_RK4_COMP,
     BLACK_HOLE_RAY_MARCHING_RK2_COMP,
     BLACK_HOLE_RAY_MARCHING_RK1_COMP,
+    BLACK_HOLE_RAY_MARCHING_RK45_COMP,
     BLACK_HOLE_RAY_QUERY_COMP,
     BLACK_HOLE_PRECOMPUTED_COMP,
+    BLACK_HOLE_ANALYTIC_COMP,
     BLACK_HOLE_PRECOMPUTE_PHI_TEXTURE_COMP,
     BLACK_HOLE_PRECOMPUTE_ACCR_DISK_DATA_TEXTURE_COMP,
+    BLACK_HOLE_RECONSTRUCT_COMP,
 };
 
+// SPIR-V code of the shader, it is used as a part of cache keys
+std::vector<uint32_t> const & GetShaderCode(SHADER_LIST_ID id);
+
 class ShaderModule final {
 public:
     ShaderModule(VkDevice device, SHADER_LIST_ID id);
@@ -1,6 +1,9 @@
 #include "utils.hpp"
 #include "my_vulkan/vulkan_functions.hpp"
+#include "my_vulkan/gpu_profiler.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <cstring>
 
@@ -18,9 +21,18 @@ DebugUtils::LabelGuard::LabelGuard(VkCommandBuffer commandBuffer, char const *na
 
     vkCmdBeginDebugUtilsLabelEXT(commandBuffer, &label);
 #endif // VULKAN_DEBUG_NAMES, VULKAN_DEBUG_VALIDATION_LAYERS
+
+    profiler = GPUProfiler::GetActive(commandBuffer);
+    if (profiler) {
+        scope = profiler->BeginScope(name);
+    }
 }
 
 DebugUtils::LabelGuard::~LabelGuard() {
+    if (profiler) {
+        profiler->EndScope(scope);
+    }
+
 #if defined(VULKAN_DEBUG_NAMES) || defined (VULKAN_DEBUG_VALIDATION_LAYERS)
     vkCmdEndDebugUtilsLabelEXT(commandBuffer);
 #endif // VULKAN_DEBUG_NAMES, VULKAN_DEBUG_VALIDATION_LAYERS
@@ -67,12 +79,8 @@ VKAPI_ATTR VkBool32 VKAPI_CALL DebugUtils::DebugCallback(VkDebugUtilsMessageSeve
     return VK_FALSE;
 }
 
-void CopyMemoryIntoStagingBuffer(VkDevice device, Buffer &stagingBuffer, void *data, VkDeviceSize size) {
-    std::vector<uint8_t> mappedStagingBuffer(size);
-    void *pMappedStagingBuffer = mappedStagingBuffer.data();
-    VK_CALL(vkMapMemory(device, stagingBuffer.deviceMemory, stagingBuffer.deviceMemoryOffset, size, 0U, &pMappedStagingBuffer));
-
-    std::memcpy(pMappedStagingBuffer, data, size);
+void CopyMemoryIntoStagingBuffer(VkDevice device, Buffer &stagingBuffer, void const *data, VkDeviceSize size) {
+    std::memcpy(stagingBuffer.pMappedData, data, size);
 
     VkMappedMemoryRange mappedMemoryRange {
         .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
@@ -83,8 +91,6 @@ void CopyMemoryIntoStagingBuffer(VkDevice device, Buffer &stagingBuffer, void *d
     };
 
     VK_CALL(vkFlushMappedMemoryRanges(device, 1U, &mappedMemoryRange));
-
-    vkUnmapMemory(device, stagingBuffer.deviceMemory);
 }
 
 void ImageChangeProperties(Image& image, VkImageLayout newLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
@@ -123,4 +129,76 @@ void ImagePipelineBarrier(VkCommandBuffer commandBuffer, Image &target, VkImageL
     ImageChangeProperties(target, dstLayout, dstStage, dstAccess);
 }
 
+void GetDeviceUUID(VkPhysicalDevice physicalDevice, uint32_t apiVersion, uint8_t (&deviceUUID)[VK_UUID_SIZE]) {
+    if (apiVersion < VK_API_VERSION_1_1) {
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        std::memcpy(deviceUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        return;
+    }
+
+    VkPhysicalDeviceIDProperties idProperties {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        .pNext = nullptr
+    };
+
+    VkPhysicalDeviceProperties2 properties {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &idProperties
+    };
+
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+    std::memcpy(deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+}
+
+uint32_t GetMipLevelsNum(VkExtent3D extent) {
+    return static_cast<uint32_t>(std::bit_width(std::max({extent.width, extent.height, extent.depth})));
+}
+
+void GenerateMipLevels(VkCommandBuffer commandBuffer, Image &target, uint32_t levelsNum, uint32_t layersNum) {
+    VkImageMemoryBarrier imageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = target.image,
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, 0U, layersNum}
+    };
+
+    auto const levelExtent = [&target](uint32_t levelIdx) {
+        return VkOffset3D{
+            .x = static_cast<int32_t>(std::max(target.size.width >> levelIdx, 1U)),
+            .y = static_cast<int32_t>(std::max(target.size.height >> levelIdx, 1U)),
+            .z = static_cast<int32_t>(std::max(target.size.depth >> levelIdx, 1U))
+        };
+    };
+
+    // The source level is switched to TRANSFER_SRC_OPTIMAL after it is written, the last one after the loop
+    for (uint32_t levelIdx = 1U; levelIdx < levelsNum; levelIdx++) {
+        imageMemoryBarrier.subresourceRange.baseMipLevel = levelIdx - 1U;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0U,
+            0U, nullptr, 0U, nullptr, 1U, &imageMemoryBarrier);
+
+        VkImageBlit const imageBlit {
+            .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, levelIdx - 1U, 0U, layersNum},
+            .srcOffsets = {{0, 0, 0}, levelExtent(levelIdx - 1U)},
+            .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, levelIdx, 0U, layersNum},
+            .dstOffsets = {{0, 0, 0}, levelExtent(levelIdx)}
+        };
+
+        vkCmdBlitImage(commandBuffer, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &imageBlit, VK_FILTER_LINEAR);
+    }
+
+    imageMemoryBarrier.subresourceRange.baseMipLevel = levelsNum - 1U;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0U,
+        0U, nullptr, 0U, nullptr, 1U, &imageMemoryBarrier);
+
+    ImageChangeProperties(target, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+}
+
 }
\ No newline at end of file
@@ -24,12 +24,18 @@ struct Buffer {
     VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
     VkDeviceSize deviceMemoryOffset = 0ULL;
     VkDeviceSize size = 0ULL;
+    // Host visible memory is mapped by GPUAllocator for its whole lifetime, it is nullptr otherwise
+    uint8_t *pMappedData = nullptr;
 };
 
 namespace Utils {
 
+class GPUProfiler;
+
 class DebugUtils final {
 public:
+    // Debug label, which is also GPU timestamp scope if the command buffer is recorded by the active GPUProfiler.
+    // `name` must be a string literal, because timestamp results are read a few frames later.
     class LabelGuard final {
     public:
         LabelGuard(VkCommandBuffer commandBuffer, char const *name, float r, float g, float b);
@@ -43,6 +49,8 @@ public:
 
     private:
         VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        GPUProfiler *profiler = nullptr;
+        uint32_t scope = 0U;
     };
 
     static void Name(VkDevice device, VkObjectType objectType, auto object, const char* name) {
@@ -66,7 +74,7 @@ private:
     static void NameImpl(VkDevice device, VkDebugUtilsObjectNameInfoEXT const &objectNameInfo);
 };
 
-void CopyMemoryIntoStagingBuffer(VkDevice device, Buffer &stagingBuffer, void *data, VkDeviceSize size);
+void CopyMemoryIntoStagingBuffer(VkDevice device, Buffer &stagingBuffer, void const *data, VkDeviceSize size);
 
 void MemoryPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
 
@@ -74,6 +82,16 @@ void ImageChangeProperties(Image& image, VkImageLayout newLayout, VkPipelineStag
 
 void ImagePipelineBarrier(VkCommandBuffer commandBuffer, Image &target, VkImageLayout dstLayout, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkImageSubresourceRange subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0U, 1U, 0U, 1U});
 
+// Device UUID needs Vulkan 1.1, the pipeline cache UUID of Vulkan 1.0 identifies the device and its driver instead
+void GetDeviceUUID(VkPhysicalDevice physicalDevice, uint32_t apiVersion, uint8_t (&deviceUUID)[VK_UUID_SIZE]);
+
+// Levels of a full mip chain of the extent
+uint32_t GetMipLevelsNum(VkExtent3D extent);
+
+// Every level is blitted from the previous one by a linear filter, the format must support linear blits.
+// All levels must be in TRANSFER_DST_OPTIMAL layout, they are left in TRANSFER_SRC_OPTIMAL layout.
+void GenerateMipLevels(VkCommandBuffer commandBuffer, Image &target, uint32_t levelsNum, uint32_t layersNum);
+
 }
 
 }
\ No newline at end of file
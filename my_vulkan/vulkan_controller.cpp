@@ -6,56 +6,176 @@
 #include <algorithm>
 #include <format>
 #include <cstring>
+#include <iostream>
 #include <optional>
 
 namespace {
 
 constexpr char const *VK_LAYER_KHRONOS_VALIDATION_NAME = "VK_LAYER_KHRONOS_validation";
 
-#ifdef BLACK_HOLE_RAY_QUERY
+// Vulkan 1.2 is required for ray query mode, other modes use only Vulkan 1.0 functionality.
+// It is the highest requested version, older loaders and devices get their own one.
 constexpr uint32_t VULKAN_API_VERSION = VK_API_VERSION_1_2;
-#else
-constexpr uint32_t VULKAN_API_VERSION = VK_API_VERSION_1_0;
-#endif // BLACK_HOLE_RAY_QUERY
 
+// They are not used in headless mode.
 constexpr char const *requiredDeviceExtensions[] = {
-#ifdef BLACK_HOLE_RAY_QUERY
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+};
+
+// They are enabled only if the device supports all of them.
+constexpr char const *rayQueryDeviceExtensions[] = {
     VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
     VK_KHR_RAY_QUERY_EXTENSION_NAME,
-    VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
-#endif // BLACK_HOLE_RAY_QUERY
-    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+    VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME
 };
 
 constexpr char const *requiredInstanceLayers[] = {
     VK_LAYER_KHRONOS_VALIDATION_NAME
 };
 
+// Version of the device is used only up to the version of the instance
+uint32_t GetDeviceApiVersion(VkPhysicalDevice physicalDevice, uint32_t instanceApiVersion) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return std::min(properties.apiVersion, instanceApiVersion);
+}
+
+bool IsRayQuerySupported(VkPhysicalDevice physicalDevice, uint32_t apiVersion) {
+    if (apiVersion < VK_API_VERSION_1_2) {
+        return false;
+    }
+
+    uint32_t extensionCount = 0U;
+    VK_CALL(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr));
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    VK_CALL(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data()));
+
+    for (char const *requiredExtension : rayQueryDeviceExtensions) {
+        bool const isFound = std::ranges::any_of(extensions, [requiredExtension](VkExtensionProperties const &extension){
+            return std::strcmp(extension.extensionName, requiredExtension) == 0;
+        });
+
+        if (!isFound) {
+            return false;
+        }
+    }
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = nullptr
+    };
+
+    VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR,
+        .pNext = &vulkan12Features
+    };
+
+    VkPhysicalDeviceAccelerationStructureFeaturesKHR asFeatures {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR,
+        .pNext = &rayQueryFeatures
+    };
+
+    VkPhysicalDeviceFeatures2 features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &asFeatures
+    };
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return (features.features.shaderInt64 == VK_TRUE) &&
+        (vulkan12Features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE) &&
+        (vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE) &&
+        (vulkan12Features.bufferDeviceAddress == VK_TRUE) &&
+        (rayQueryFeatures.rayQuery == VK_TRUE) &&
+        (asFeatures.accelerationStructure == VK_TRUE);
+}
+
+// Async compute queue is synchronized with frames by a timeline semaphore
+bool IsTimelineSemaphoreSupported(VkPhysicalDevice physicalDevice, uint32_t apiVersion) {
+    if (apiVersion < VK_API_VERSION_1_2) {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = nullptr
+    };
+
+    VkPhysicalDeviceFeatures2 features {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &vulkan12Features
+    };
+
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+    return vulkan12Features.timelineSemaphore == VK_TRUE;
+}
+
 }
 
 namespace KRV {
 
-VulkanController::VulkanController() {
+VulkanController::VulkanController(bool isHeadless, BlackHoleSpecialization const &specialization) : isHeadless(isHeadless) {
     LoadVulkanGlobalFunctions();
     InitInstance();
     LoadVulkanInstanceFunctions(instance);
+    if (apiVersion >= VK_API_VERSION_1_1) {
+        LoadVulkan11InstanceFunctions(instance);
+    }
 #ifdef VULKAN_DEBUG_VALIDATION_LAYERS
     InitDebugUtilsMessanger();
 #endif // VULKAN_DEBUG_VALIDATION_LAYERS
-    InitSurface();
+    if (!isHeadless) {
+        InitSurface();
+    }
     InitPhysicalDevice();
+    apiVersion = GetDeviceApiVersion(physicalDevice, apiVersion);
+    isRayQuerySupported = IsRayQuerySupported(physicalDevice, apiVersion);
+    isTimelineSemaphoreSupported = IsTimelineSemaphoreSupported(physicalDevice, apiVersion);
+    // Files don't need the device, so they are decoded while the rest of Vulkan is initialized
+    core.LoadAssets(jobSystem, physicalDevice, isRayQuerySupported);
     InitQueueFamilyIndex();
     InitDevice();
     LoadVulkanDeviceFunctions(device);
+    if (isRayQuerySupported) {
+        LoadVulkanRayQueryDeviceFunctions(device);
+    }
+    if (computeQueueFamilyIndex != queueFamilyIndex) {
+        LoadVulkanTimelineSemaphoreDeviceFunctions(device);
+    }
     InitQueue();
-    InitSwapchain();
+
+    // Core creates only its own objects, so it is initialized by a job alongside presentation and command buffers
+    JobSystem::Group coreGroup{};
+    jobSystem.Submit(coreGroup, [this, &specialization](){
+        core.Init(physicalDevice, device, apiVersion, isRayQuerySupported, isPrecomputedSupported, specialization, jobSystem);
+    });
+
+    if (isHeadless) {
+        InitReadbackBuffers();
+    } else {
+        InitSwapchain();
+    }
     InitCommandBuffers();
+    if (transferQueueFamilyIndex != queueFamilyIndex) {
+        InitUpload();
+    }
+    if (computeQueueFamilyIndex != queueFamilyIndex) {
+        InitAsyncCompute();
+    }
+    gpuProfiler.Init(physicalDevice, device, queueFamilyIndex, FRAMES_IN_FLIGHT);
+
+    jobSystem.Wait(coreGroup);
 
-    core.Init(physicalDevice, device);
+    std::cout << std::format("[VulkanController] Initialization: {:.1f} ms, {} workers",
+        1000.0*startupClock.GetTime(), jobSystem.GetWorkersNum()) << std::endl;
 }
 
 void VulkanController::InitInstance() {
-    std::vector<const char*> extensions = Window::GetInstance().GetVulkanSurfaceExtensions();
+    std::vector<const char*> extensions{};
+    if (!isHeadless) {
+        extensions = Window::GetInstance().GetVulkanSurfaceExtensions();
+    }
 #if defined(VULKAN_DEBUG_NAMES) || defined(VULKAN_DEBUG_VALIDATION_LAYERS)
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 #ifdef VULKAN_DEBUG_VALIDATION_LAYERS
@@ -63,6 +183,13 @@ void VulkanController::InitInstance() {
 #endif // VULKAN_DEBUG_VALIDATION_LAYERS
 #endif // VULKAN_DEBUG_NAMES, VULKAN_DEBUG_VALIDATION_LAYERS
 
+    // Vulkan 1.0 loaders don't have vkEnumerateInstanceVersion and fail instance creation with a higher version
+    uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+    if (vkEnumerateInstanceVersion != nullptr) {
+        VK_CALL(vkEnumerateInstanceVersion(&instanceApiVersion));
+    }
+    apiVersion = std::min(instanceApiVersion, VULKAN_API_VERSION);
+
     VkApplicationInfo applicationInfo {
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pNext = nullptr,
@@ -70,7 +197,7 @@ void VulkanController::InitInstance() {
         .applicationVersion = 1,
         .pEngineName = "EngineName",
         .engineVersion = 1,
-        .apiVersion = VULKAN_API_VERSION
+        .apiVersion = apiVersion
     };
 
     VkInstanceCreateInfo instanceCI {
@@ -167,6 +294,7 @@ void VulkanController::InitPhysicalDevice() {
     struct PhysicalDeviceInfo {
         std::optional<uint32_t> discreteIndex = std::nullopt;
         std::optional<uint32_t> integratedIndex = std::nullopt;
+        std::optional<uint32_t> cpuIndex = std::nullopt;
     } physicalDeviceInfo;
 
     for (uint32_t i = 0U; i < physicalDeviceCount; i++) {
@@ -174,12 +302,15 @@ void VulkanController::InitPhysicalDevice() {
         vkGetPhysicalDeviceProperties(physicalDevices[i], &properties);
         if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {physicalDeviceInfo.discreteIndex = i;}
         if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) {physicalDeviceInfo.integratedIndex = i;}
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {physicalDeviceInfo.cpuIndex = i;}
     }
 
 #ifndef VULKAN_IGNORE_DISCRETE_GPU
     if (auto const &idx = physicalDeviceInfo.discreteIndex; idx) {physicalDevice = physicalDevices[*idx]; return;}
 #endif // VULKAN_IGNORE_DISCRETE_GPU
     if (auto const &idx = physicalDeviceInfo.integratedIndex; idx) {physicalDevice = physicalDevices[*idx]; return;}
+    // Software rasterizers (e.g. lavapipe) are used only in headless mode, for example in CI
+    if (auto const &idx = physicalDeviceInfo.cpuIndex; idx && isHeadless) {physicalDevice = physicalDevices[*idx]; return;}
 
     throw std::runtime_error("There is no discrete or integrated phisical device");
 }
@@ -198,16 +329,44 @@ void VulkanController::InitQueueFamilyIndex() {
     constexpr VkQueueFlags requiredQueueFlags = (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT);
     for (queueFamilyIndex = 0U; queueFamilyIndex < queueFamilyCount; queueFamilyIndex++) {
         if ((queueFamilyProperties[queueFamilyIndex].queueFlags & requiredQueueFlags) == requiredQueueFlags) {
+            if (isHeadless) {
+                break;
+            }
+
             VkBool32 presentationSupport = VK_FALSE;
             VK_CALL(vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, queueFamilyIndex, surface, &presentationSupport));
             if (presentationSupport == VK_TRUE) {
-                return;
+                break;
             }
         }
     }
 
-    // May be only graphic queue and only compute queue, but I ignore this case, because I am in comfort zone.
-    throw std::runtime_error(R"(queueFamilies don't support graphics, comput, transfer and presentation together)");
+    if (queueFamilyIndex == queueFamilyCount) {
+        // May be only graphic queue and only compute queue, but I ignore this case, because I am in comfort zone.
+        throw std::runtime_error(R"(queueFamilies don't support graphics, comput, transfer and presentation together)");
+    }
+
+    // Transfer-only families are served by copy engines, so assets are uploaded alongside the work of frames.
+    // Without such a family the first frame uploads them itself.
+    transferQueueFamilyIndex = queueFamilyIndex;
+    for (uint32_t idx = 0U; idx < queueFamilyCount; idx++) {
+        VkQueueFlags const queueFlags = queueFamilyProperties[idx].queueFlags;
+        if ((queueFlags & VK_QUEUE_TRANSFER_BIT) != 0U && (queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0U) {
+            transferQueueFamilyIndex = idx;
+            break;
+        }
+    }
+
+    // Compute families without graphics run alongside frames, their completion is polled through a timeline semaphore.
+    // Without such a family or timeline semaphores precomputed tables are generated by a frame.
+    computeQueueFamilyIndex = queueFamilyIndex;
+    for (uint32_t idx = 0U; isTimelineSemaphoreSupported && idx < queueFamilyCount; idx++) {
+        VkQueueFlags const queueFlags = queueFamilyProperties[idx].queueFlags;
+        if ((queueFlags & VK_QUEUE_COMPUTE_BIT) != 0U && (queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0U) {
+            computeQueueFamilyIndex = idx;
+            break;
+        }
+    }
 }
 
 void VulkanController::InitDevice() {
@@ -220,24 +379,49 @@ void VulkanController::InitDevice() {
         .pQueuePriorities = &ONE_FLOAT
     };
 
+    // Dedicated transfer and async compute queues are created only if their families differ from the main one
+    std::vector<VkDeviceQueueCreateInfo> deviceQueueCIs = {deviceQueueCI};
+    for (uint32_t const sideQueueFamilyIndex : {transferQueueFamilyIndex, computeQueueFamilyIndex}) {
+        if (sideQueueFamilyIndex != queueFamilyIndex) {
+            deviceQueueCIs.push_back(deviceQueueCI);
+            deviceQueueCIs.back().queueFamilyIndex = sideQueueFamilyIndex;
+        }
+    }
+
+    std::vector<char const *> deviceExtensions{};
+    if (!isHeadless) {
+        deviceExtensions.assign(std::begin(requiredDeviceExtensions), std::end(requiredDeviceExtensions));
+    }
+
     ////////////// Physical Device Features Structure //////////////
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
+#if defined(PRECOMPUTED_TABLE_FLOAT16) || defined(PRECOMPUTED_TABLE_UNORM16)
+    // Precompute shaders write 16-bit two-component storage images, other modes don't need them
+    isPrecomputedSupported = (supportedFeatures.shaderStorageImageExtendedFormats == VK_TRUE);
+#endif // PRECOMPUTED_TABLE_FLOAT16, PRECOMPUTED_TABLE_UNORM16
+
+    // Block compressed sky is used only if this feature is supported
     VkPhysicalDeviceFeatures physicalDeviceFeatures {
-#ifdef BLACK_HOLE_RAY_QUERY
-        .shaderInt64 = VK_TRUE
-#endif // BLACK_HOLE_RAY_QUERY
+        .textureCompressionBC = supportedFeatures.textureCompressionBC,
+        .shaderStorageImageExtendedFormats = supportedFeatures.shaderStorageImageExtendedFormats,
+        .shaderInt64 = (isRayQuerySupported ? VK_TRUE : VK_FALSE)
     };
     ////////////////////////////////////////////////////////////////
 
     void *deviceCIpNext = nullptr;
 
     ///////////////// Device Extensions Structures /////////////////
-#ifdef BLACK_HOLE_RAY_QUERY
+    VkBool32 const rayQueryFeature = isRayQuerySupported ? VK_TRUE : VK_FALSE;
+    bool const isAsyncComputeUsed = (computeQueueFamilyIndex != queueFamilyIndex);
     VkPhysicalDeviceVulkan12Features vulkan12Features {
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
         .pNext = nullptr,
-        .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
-        .descriptorBindingPartiallyBound = VK_TRUE,
-        .bufferDeviceAddress = VK_TRUE
+        .shaderSampledImageArrayNonUniformIndexing = rayQueryFeature,
+        .descriptorBindingPartiallyBound = rayQueryFeature,
+        .timelineSemaphore = isAsyncComputeUsed ? VK_TRUE : VK_FALSE,
+        .bufferDeviceAddress = rayQueryFeature
     };
 
     VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures {
@@ -256,20 +440,24 @@ void VulkanController::InitDevice() {
         .descriptorBindingAccelerationStructureUpdateAfterBind = VK_FALSE
     };
 
-    deviceCIpNext = &asFeatures;
-#endif // BLACK_HOLE_RAY_QUERY
+    if (isRayQuerySupported) {
+        deviceExtensions.insert(deviceExtensions.end(), std::begin(rayQueryDeviceExtensions), std::end(rayQueryDeviceExtensions));
+        deviceCIpNext = &asFeatures;
+    } else if (isAsyncComputeUsed) {
+        deviceCIpNext = &vulkan12Features;
+    }
     ////////////////////////////////////////////////////////////////
 
     VkDeviceCreateInfo deviceCI {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .pNext = deviceCIpNext,
         .flags = 0U,
-        .queueCreateInfoCount = 1U,
-        .pQueueCreateInfos = &deviceQueueCI,
+        .queueCreateInfoCount = static_cast<uint32_t>(deviceQueueCIs.size()),
+        .pQueueCreateInfos = deviceQueueCIs.data(),
         .enabledLayerCount = 0U,
         .ppEnabledLayerNames = nullptr,
-        .enabledExtensionCount = static_cast<uint32_t>(std::size(requiredDeviceExtensions)),
-        .ppEnabledExtensionNames = requiredDeviceExtensions,
+        .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
+        .ppEnabledExtensionNames = deviceExtensions.data(),
         .pEnabledFeatures = &physicalDeviceFeatures
     };
 
@@ -278,6 +466,8 @@ void VulkanController::InitDevice() {
 
 void VulkanController::InitQueue() {
     vkGetDeviceQueue(device, queueFamilyIndex, 0U, &queue);
+    vkGetDeviceQueue(device, transferQueueFamilyIndex, 0U, &transferQueue);
+    vkGetDeviceQueue(device, computeQueueFamilyIndex, 0U, &computeQueue);
 }
 
 void VulkanController::InitSwapchain() {
@@ -380,6 +570,30 @@ void VulkanController::InitSwapchain() {
 }
 
 
+void VulkanController::InitReadbackBuffers() {
+    Utils::GPUAllocator &readbackAllocator = headlessInfo.readbackAllocator;
+    readbackAllocator.Init(physicalDevice);
+
+    for (uint32_t i = 0U; i < FRAMES_IN_FLIGHT; i++) {
+        Utils::CreateBufferInfo readbackBufferCI {
+            .size = static_cast<VkDeviceSize>(WINDOW_SIZE_WIDTH)*WINDOW_SIZE_HEIGHT*4U*sizeof(uint8_t),
+            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .name = std::format("VulkanController::ReadbackBuffer [{}]", i)
+        };
+
+        // Coherent memory doesn't need invalidation before reading
+        headlessInfo.readbackBuffers[i] = &readbackAllocator.AddBuffer(device, readbackBufferCI,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0U);
+    }
+
+    readbackAllocator.PresentResources(device);
+
+    // Readback memory is mapped by the allocator for the whole lifetime
+    for (uint32_t i = 0U; i < FRAMES_IN_FLIGHT; i++) {
+        headlessInfo.mappedReadbackBuffers[i] = headlessInfo.readbackBuffers[i]->pMappedData;
+    }
+}
+
 void VulkanController::InitCommandBuffers() {
     constexpr VkFenceCreateInfo fenceCI {
         .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
@@ -429,7 +643,206 @@ void VulkanController::InitCommandBuffers() {
     }
 }
 
-void VulkanController::RecordCommandBuffer(VkImage swapchainImage, uint32_t fif) {
+void VulkanController::InitUpload() {
+    VkCommandPoolCreateInfo commandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = transferQueueFamilyIndex
+    };
+
+    VK_CALL(vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &uploadInfo.commandPool));
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = uploadInfo.commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1U
+    };
+
+    VK_CALL(vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &uploadInfo.commandBuffer));
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_COMMAND_BUFFER, uploadInfo.commandBuffer, "Upload Command Buffer");
+
+    constexpr VkSemaphoreCreateInfo semaphoreCI {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0U
+    };
+
+    VK_CALL(vkCreateSemaphore(device, &semaphoreCI, nullptr, &uploadInfo.isUploaded));
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_SEMAPHORE, uploadInfo.isUploaded, "Transfer Queue IsUploaded Semaphore");
+}
+
+void VulkanController::InitAsyncCompute() {
+    VkCommandPoolCreateInfo commandPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = computeQueueFamilyIndex
+    };
+
+    VK_CALL(vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &asyncComputeInfo.commandPool));
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = asyncComputeInfo.commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1U
+    };
+
+    VK_CALL(vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &asyncComputeInfo.commandBuffer));
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_COMMAND_BUFFER, asyncComputeInfo.commandBuffer, "Async Compute Command Buffer");
+
+    constexpr VkSemaphoreTypeCreateInfo semaphoreTypeCI {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0ULL
+    };
+
+    VkSemaphoreCreateInfo const semaphoreCI {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &semaphoreTypeCI,
+        .flags = 0U
+    };
+
+    VK_CALL(vkCreateSemaphore(device, &semaphoreCI, nullptr, &asyncComputeInfo.timeline));
+    Utils::DebugUtils::Name(device, VK_OBJECT_TYPE_SEMAPHORE, asyncComputeInfo.timeline, "Async Compute Timeline Semaphore");
+}
+
+void VulkanController::SubmitUpload(SubmitWaits &waits) {
+    if (uploadInfo.commandBuffer == VK_NULL_HANDLE || uploadInfo.isSubmitted) {
+        return;
+    }
+
+    constexpr VkCommandBufferBeginInfo commandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr
+    };
+
+    VK_CALL(vkBeginCommandBuffer(uploadInfo.commandBuffer, &commandBufferBeginInfo));
+    core.RecordUpload(device, uploadInfo.commandBuffer, transferQueueFamilyIndex, queueFamilyIndex);
+    VK_CALL(vkEndCommandBuffer(uploadInfo.commandBuffer));
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreCount = 0U,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1U,
+        .pCommandBuffers = &uploadInfo.commandBuffer,
+        .signalSemaphoreCount = 1U,
+        .pSignalSemaphores = &uploadInfo.isUploaded
+    };
+
+    // Frames don't wait for the fence of the upload, the first one waits for the semaphore on GPU.
+    // Uploaded resources are acquired by barriers of the transfer stage, so the upload is waited only there.
+    VK_CALL(vkQueueSubmit(transferQueue, 1U, &submitInfo, VK_NULL_HANDLE));
+    uploadInfo.isSubmitted = true;
+
+    waits.Add(uploadInfo.isUploaded, VK_PIPELINE_STAGE_TRANSFER_BIT);
+}
+
+void VulkanController::SubmitAsyncCompute(SubmitWaits &waits) {
+    if (asyncComputeInfo.commandBuffer == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // The frame, which follows completion, waits for the reached value. It doesn't stall, but it makes tables visible.
+    // Tables are acquired only by frames of the precomputed mode, so completion is not taken meanwhile.
+    if (asyncComputeInfo.isPending) {
+        if (core.GetRenderMode() != RENDER_MODE::PRECOMPUTED) {
+            return;
+        }
+
+        uint64_t value = 0ULL;
+        VK_CALL(vkGetSemaphoreCounterValue(device, asyncComputeInfo.timeline, &value));
+        if (value < asyncComputeInfo.timelineValue) {
+            return;
+        }
+
+        asyncComputeInfo.isPending = false;
+        core.FinishAsyncCompute();
+        waits.Add(asyncComputeInfo.timeline, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, asyncComputeInfo.timelineValue);
+    }
+
+    // Tables are generated by slices, the next one is submitted right after completion of the previous one
+    if (!core.HasAsyncCompute()) {
+        return;
+    }
+
+    VK_CALL(vkResetCommandPool(device, asyncComputeInfo.commandPool, 0U));
+
+    constexpr VkCommandBufferBeginInfo commandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr
+    };
+
+    VK_CALL(vkBeginCommandBuffer(asyncComputeInfo.commandBuffer, &commandBufferBeginInfo));
+    core.RecordAsyncCompute(device, asyncComputeInfo.commandBuffer, computeQueueFamilyIndex, queueFamilyIndex);
+    VK_CALL(vkEndCommandBuffer(asyncComputeInfo.commandBuffer));
+
+    uint64_t const signalValue = ++asyncComputeInfo.timelineValue;
+
+    VkTimelineSemaphoreSubmitInfo const timelineSubmitInfo {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = 0U,
+        .pWaitSemaphoreValues = nullptr,
+        .signalSemaphoreValueCount = 1U,
+        .pSignalSemaphoreValues = &signalValue
+    };
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &timelineSubmitInfo,
+        .waitSemaphoreCount = 0U,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1U,
+        .pCommandBuffers = &asyncComputeInfo.commandBuffer,
+        .signalSemaphoreCount = 1U,
+        .pSignalSemaphores = &asyncComputeInfo.timeline
+    };
+
+    VK_CALL(vkQueueSubmit(computeQueue, 1U, &submitInfo, VK_NULL_HANDLE));
+    asyncComputeInfo.isPending = true;
+}
+
+void VulkanController::SubmitFrame(SubmitWaits const &waits, VkSemaphore signalSemaphore, uint32_t fif) {
+    // Values are given only if the timeline semaphore may be among waits
+    VkTimelineSemaphoreSubmitInfo const timelineSubmitInfo {
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = static_cast<uint32_t>(waits.values.size()),
+        .pWaitSemaphoreValues = waits.values.data(),
+        .signalSemaphoreValueCount = 0U,
+        .pSignalSemaphoreValues = nullptr
+    };
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = (asyncComputeInfo.timeline != VK_NULL_HANDLE) ? &timelineSubmitInfo : nullptr,
+        .waitSemaphoreCount = static_cast<uint32_t>(waits.semaphores.size()),
+        .pWaitSemaphores = waits.semaphores.data(),
+        .pWaitDstStageMask = waits.stageMasks.data(),
+        .commandBufferCount = 1U,
+        .pCommandBuffers = &commandBufferInfo.commandBuffers[fif],
+        .signalSemaphoreCount = (signalSemaphore != VK_NULL_HANDLE) ? 1U : 0U,
+        .pSignalSemaphores = &signalSemaphore
+    };
+
+    VK_CALL(vkQueueSubmit(queue, 1U, &submitInfo, commandBufferInfo.commandBufferFences[fif]));
+}
+
+void VulkanController::RecordCommandBuffer(VkImage swapchainImage, uint32_t fif, Camera const &camera) {
     VkCommandPool commandPool = commandBufferInfo.commandPools[fif];
     VkCommandBuffer commandBuffer = commandBufferInfo.commandBuffers[fif];
 
@@ -444,106 +857,175 @@ void VulkanController::RecordCommandBuffer(VkImage swapchainImage, uint32_t fif)
 
     VK_CALL(vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo));
 
+    // Fence of this frame in flight is already waited, so timestamps of its previous frame are ready
+    gpuProfiler.BeginFrame(device, commandBuffer, fif);
+
+    double gpuFrameTime = 0.0;
+    for (auto const &timing : gpuProfiler.GetTimings()) {
+        if (timing.depth == 0U) {
+            gpuFrameTime += timing.milliseconds;
+        }
+    }
+    core.UpdateFrameTime(gpuFrameTime);
+
     {
         Utils::DebugUtils::LabelGuard labelGeneralGuard(commandBuffer, "RecordCommandBuffer", 0.7F, 0.7F, 0.7F);
 
-        Image& finalImage = core.RecordCommandBuffer(device, commandBuffer);
+        Image& finalImage = core.RecordCommandBuffer(device, commandBuffer, camera);
 
-        {
-            Utils::DebugUtils::LabelGuard labelBlitGuard(commandBuffer, "Final Blit", 1.0F, 1.0F, 1.0F);
-
-            VkImageMemoryBarrier const firstImageMemoryBarrier {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .pNext = nullptr,
-                .srcAccessMask = 0U,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = swapchainImage,
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0U,
-                    .levelCount = 1U,
-                    .baseArrayLayer = 0U,
-                    .layerCount = 1U
-                }
-            };
-
-            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0U, nullptr, 0U, nullptr, 1U, &firstImageMemoryBarrier);
-
-            VkImageBlit const region = VkImageBlit{
-                .srcSubresource = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .mipLevel = 0U,
-                    .baseArrayLayer = 0U,
-                    .layerCount = 1U
-                },
-                .srcOffsets = {
-                    {
-                        .x = 0,
-                        .y = 0,
-                        .z = 0
-                    },
-                    {
-                        .x = static_cast<int32_t>(WINDOW_SIZE_WIDTH),
-                        .y = static_cast<int32_t>(WINDOW_SIZE_HEIGHT),
-                        .z = 1
-                    }
-                },
-                .dstSubresource = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .mipLevel = 0U,
-                    .baseArrayLayer = 0U,
-                    .layerCount = 1U
-                },
-                .dstOffsets = {
-                    {
-                        .x = 0,
-                        .y = 0,
-                        .z = 0
-                    },
-                    {
-                        .x = static_cast<int32_t>(swapchainInfo.extent.width),
-                        .y = static_cast<int32_t>(swapchainInfo.extent.height),
-                        .z = 1
-                    }
-                }
-            };
-
-            vkCmdBlitImage(commandBuffer, finalImage.image, finalImage.layout, swapchainImage,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &region, VK_FILTER_LINEAR);
-
-            VkImageMemoryBarrier const secondImageMemoryBarrier {
-                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                .pNext = nullptr,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = 0U,
-                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .image = swapchainImage,
-                .subresourceRange = {
-                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                    .baseMipLevel = 0U,
-                    .levelCount = 1U,
-                    .baseArrayLayer = 0U,
-                    .layerCount = 1U
-                }
-            };
-
-            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                VK_DEPENDENCY_BY_REGION_BIT, 0U, nullptr, 0U, nullptr, 1U, &secondImageMemoryBarrier);
+        if (isHeadless) {
+            RecordFinalCopy(commandBuffer, finalImage, fif);
+        } else {
+            RecordFinalBlit(commandBuffer, finalImage, swapchainImage);
         }
     }
 
+    gpuProfiler.EndFrame();
+
     VK_CALL(vkEndCommandBuffer(commandBuffer));
 }
 
-void VulkanController::DrawFrame() {
+void VulkanController::RecordFinalBlit(VkCommandBuffer commandBuffer, Image &finalImage, VkImage swapchainImage) {
+    Utils::DebugUtils::LabelGuard labelBlitGuard(commandBuffer, "Final Blit", 1.0F, 1.0F, 1.0F);
+
+    VkImageMemoryBarrier const firstImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = 0U,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = swapchainImage,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0U,
+            .levelCount = 1U,
+            .baseArrayLayer = 0U,
+            .layerCount = 1U
+        }
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0U, nullptr, 0U, nullptr, 1U, &firstImageMemoryBarrier);
+
+    // Reduced render extent is stretched over the whole swapchain image
+    VkExtent2D const renderExtent = core.GetRenderExtent();
+
+    VkImageBlit const region = VkImageBlit{
+        .srcSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0U,
+            .baseArrayLayer = 0U,
+            .layerCount = 1U
+        },
+        .srcOffsets = {
+            {
+                .x = 0,
+                .y = 0,
+                .z = 0
+            },
+            {
+                .x = static_cast<int32_t>(renderExtent.width),
+                .y = static_cast<int32_t>(renderExtent.height),
+                .z = 1
+            }
+        },
+        .dstSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0U,
+            .baseArrayLayer = 0U,
+            .layerCount = 1U
+        },
+        .dstOffsets = {
+            {
+                .x = 0,
+                .y = 0,
+                .z = 0
+            },
+            {
+                .x = static_cast<int32_t>(swapchainInfo.extent.width),
+                .y = static_cast<int32_t>(swapchainInfo.extent.height),
+                .z = 1
+            }
+        }
+    };
+
+    vkCmdBlitImage(commandBuffer, finalImage.image, finalImage.layout, swapchainImage,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1U, &region, VK_FILTER_LINEAR);
+
+    VkImageMemoryBarrier const secondImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = 0U,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = swapchainImage,
+        .subresourceRange = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0U,
+            .levelCount = 1U,
+            .baseArrayLayer = 0U,
+            .layerCount = 1U
+        }
+    };
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        VK_DEPENDENCY_BY_REGION_BIT, 0U, nullptr, 0U, nullptr, 1U, &secondImageMemoryBarrier);
+}
+
+void VulkanController::RecordFinalCopy(VkCommandBuffer commandBuffer, Image &finalImage, uint32_t fif) {
+    Utils::DebugUtils::LabelGuard labelCopyGuard(commandBuffer, "Final Copy", 1.0F, 1.0F, 1.0F);
+
+    // Frames are delivered in the render extent, the readback buffer fits the full one
+    VkExtent2D const renderExtent = core.GetRenderExtent();
+    headlessInfo.frameExtents[fif] = renderExtent;
+
+    VkBufferImageCopy const region {
+        .bufferOffset = 0ULL,
+        .bufferRowLength = 0U,
+        .bufferImageHeight = 0U,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0U,
+            .baseArrayLayer = 0U,
+            .layerCount = 1U
+        },
+        .imageOffset = {
+            .x = 0,
+            .y = 0,
+            .z = 0
+        },
+        .imageExtent = {
+            .width = renderExtent.width,
+            .height = renderExtent.height,
+            .depth = 1U
+        }
+    };
+
+    vkCmdCopyImageToBuffer(commandBuffer, finalImage.image, finalImage.layout,
+        headlessInfo.readbackBuffers[fif]->buffer, 1U, &region);
+
+    // Make copied data available for the host after fence waiting
+    Utils::MemoryPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+}
+
+void VulkanController::DrawFrame(Camera const &camera) {
+    if (isHeadless) {
+        DrawFrameHeadless(camera);
+        return;
+    }
+
+    // Side queues start their work before the frame is recorded
+    SubmitWaits waits{};
+    SubmitUpload(waits);
+    SubmitAsyncCompute(waits);
+
     uint32_t &fif = commandBufferInfo.fif;
     VK_CALL(vkWaitForFences(device, 1, &commandBufferInfo.commandBufferFences[fif], VK_TRUE, UINT64_MAX));
     VK_CALL(vkResetFences(device, 1, &commandBufferInfo.commandBufferFences[fif]));
@@ -551,23 +1033,10 @@ void VulkanController::DrawFrame() {
     uint32_t imageIndex = 0U;
     VK_CALL(vkAcquireNextImageKHR(device, swapchainInfo.swapchain, UINT64_MAX, commandBufferInfo.canRender[fif], VK_NULL_HANDLE, &imageIndex));
 
-    RecordCommandBuffer(swapchainInfo.images[imageIndex], fif);
+    RecordCommandBuffer(swapchainInfo.images[imageIndex], fif, camera);
 
-    constexpr VkPipelineStageFlags waitDstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
-
-    VkSubmitInfo submitInfo {
-        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 1U,
-        .pWaitSemaphores = &commandBufferInfo.canRender[fif],
-        .pWaitDstStageMask = &waitDstStageMask,
-        .commandBufferCount = 1U,
-        .pCommandBuffers = &commandBufferInfo.commandBuffers[fif],
-        .signalSemaphoreCount = 1U,
-        .pSignalSemaphores = &swapchainInfo.canPresent[imageIndex]
-    };
-
-    VK_CALL(vkQueueSubmit(queue, 1U, &submitInfo, commandBufferInfo.commandBufferFences[fif]));
+    waits.Add(commandBufferInfo.canRender[fif], VK_PIPELINE_STAGE_TRANSFER_BIT);
+    SubmitFrame(waits, swapchainInfo.canPresent[imageIndex], fif);
 
     VkPresentInfoKHR presentInfo {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -582,15 +1051,199 @@ void VulkanController::DrawFrame() {
 
     VK_CALL(vkQueuePresentKHR(queue, &presentInfo));
 
+    MeasureTimeToFirstFrame(fif);
+
     fif = ++fif % FRAMES_IN_FLIGHT;
 }
 
+void VulkanController::DrawFrameHeadless(Camera const &camera) {
+    SubmitWaits waits{};
+    SubmitUpload(waits);
+    SubmitAsyncCompute(waits);
+
+    uint32_t &fif = commandBufferInfo.fif;
+    VK_CALL(vkWaitForFences(device, 1, &commandBufferInfo.commandBufferFences[fif], VK_TRUE, UINT64_MAX));
+
+    // Readback buffer of this frame in flight is going to be overwritten, so give the old frame to the caller
+    DeliverFrame(fif);
+
+    VK_CALL(vkResetFences(device, 1, &commandBufferInfo.commandBufferFences[fif]));
+
+    RecordCommandBuffer(VK_NULL_HANDLE, fif, camera);
+    SubmitFrame(waits, VK_NULL_HANDLE, fif);
+
+    headlessInfo.isFramePending[fif] = true;
+    headlessInfo.frameIndices[fif] = headlessInfo.frameCounter++;
+
+    MeasureTimeToFirstFrame(fif);
+
+    fif = ++fif % FRAMES_IN_FLIGHT;
+}
+
+void VulkanController::MeasureTimeToFirstFrame(uint32_t fif) {
+    if (timeToFirstFrameMs > 0.0) {
+        return;
+    }
+
+    // The first frame is waited once, so the time includes its uploads and acceleration structure builds
+    VK_CALL(vkWaitForFences(device, 1, &commandBufferInfo.commandBufferFences[fif], VK_TRUE, UINT64_MAX));
+    timeToFirstFrameMs = 1000.0*startupClock.GetTime();
+
+    std::cout << std::format("[VulkanController] Time to first frame: {:.1f} ms", timeToFirstFrameMs) << std::endl;
+}
+
+void VulkanController::DeliverFrame(uint32_t fif) {
+    if (!headlessInfo.isFramePending[fif]) {
+        return;
+    }
+
+    headlessInfo.isFramePending[fif] = false;
+
+    if (headlessInfo.frameCallback) {
+        Frame const frame {
+            .pixels = headlessInfo.mappedReadbackBuffers[fif],
+            .extent = headlessInfo.frameExtents[fif],
+            .index = headlessInfo.frameIndices[fif]
+        };
+
+        headlessInfo.frameCallback(frame);
+    }
+}
+
+void VulkanController::SetFrameCallback(FrameCallback frameCallback) {
+    headlessInfo.frameCallback = std::move(frameCallback);
+}
+
+void VulkanController::FlushFrames() {
+    if (!isHeadless) {
+        return;
+    }
+
+    // Deliver frames in submission order, the oldest one is in the current frame in flight
+    for (uint32_t i = 0U; i < FRAMES_IN_FLIGHT; i++) {
+        uint32_t const fif = (commandBufferInfo.fif + i) % FRAMES_IN_FLIGHT;
+        VK_CALL(vkWaitForFences(device, 1, &commandBufferInfo.commandBufferFences[fif], VK_TRUE, UINT64_MAX));
+        DeliverFrame(fif);
+    }
+}
+
+bool VulkanController::SetRenderMode(RENDER_MODE renderMode) {
+    return core.SetRenderMode(renderMode);
+}
+
+RENDER_MODE VulkanController::GetRenderMode() const {
+    return core.GetRenderMode();
+}
+
+void VulkanController::SetRK45Tolerance(float tolerance) {
+    core.SetRK45Tolerance(tolerance);
+}
+
+float VulkanController::GetRK45Tolerance() const {
+    return core.GetRK45Tolerance();
+}
+
+bool VulkanController::SetInterleaveFactor(uint32_t factor) {
+    return core.SetInterleaveFactor(factor);
+}
+
+uint32_t VulkanController::GetInterleaveFactor() const {
+    return core.GetInterleaveFactor();
+}
+
+void VulkanController::SetProgressiveRefinement(bool isEnabled) {
+    core.SetProgressiveRefinement(isEnabled);
+}
+
+bool VulkanController::IsConverged(Camera const &camera) const {
+    return core.IsConverged(camera);
+}
+
+bool VulkanController::SetMarchingDispatch(RENDER_MODE renderMode, MARCHING_DISPATCH marchingDispatch) {
+    return core.SetMarchingDispatch(renderMode, marchingDispatch);
+}
+
+MARCHING_DISPATCH VulkanController::GetMarchingDispatch(RENDER_MODE renderMode) const {
+    return core.GetMarchingDispatch(renderMode);
+}
+
+bool VulkanController::SetWorkgroupSize(RENDER_MODE renderMode, VkExtent2D workgroupSize) {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    VkPhysicalDeviceLimits const &limits = properties.limits;
+    if (workgroupSize.width == 0U || workgroupSize.height == 0U ||
+        workgroupSize.width > limits.maxComputeWorkGroupSize[0] || workgroupSize.height > limits.maxComputeWorkGroupSize[1] ||
+        workgroupSize.width*workgroupSize.height > limits.maxComputeWorkGroupInvocations) {
+        std::cerr << std::format("[VulkanController] Workgroup size {}x{} is not supported by the device\n",
+            workgroupSize.width, workgroupSize.height);
+        return false;
+    }
+
+    // Pending frames are delivered before the wait, so none of them is lost
+    FlushFrames();
+    VK_CALL(vkDeviceWaitIdle(device));
+
+    return core.SetWorkgroupSize(device, renderMode, workgroupSize);
+}
+
+VkExtent2D VulkanController::GetWorkgroupSize(RENDER_MODE renderMode) const {
+    return core.GetWorkgroupSize(renderMode);
+}
+
+bool VulkanController::IsRenderModeReady() const {
+    return core.IsRenderModeReady();
+}
+
+void VulkanController::SetTargetFrameTime(double milliseconds) {
+    core.SetTargetFrameTime(milliseconds);
+}
+
+double VulkanController::GetTargetFrameTime() const {
+    return core.GetTargetFrameTime();
+}
+
+std::string VulkanController::GetDeviceName() const {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return properties.deviceName;
+}
+
+std::string VulkanController::GetDeviceUUID() const {
+    uint8_t deviceUUID[VK_UUID_SIZE] = {};
+    Utils::GetDeviceUUID(physicalDevice, apiVersion, deviceUUID);
+
+    std::string uuid;
+    for (uint8_t const byte : deviceUUID) {
+        uuid += std::format("{:02x}", byte);
+    }
+    return uuid;
+}
+
+uint32_t VulkanController::GetDriverVersion() const {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return properties.driverVersion;
+}
+
+std::vector<Utils::GPUProfiler::ScopeTiming> const & VulkanController::GetGPUTimings() const {
+    return gpuProfiler.GetTimings();
+}
+
+double VulkanController::GetTimeToFirstFrame() const {
+    return timeToFirstFrameMs;
+}
+
 VulkanController::~VulkanController() {
     // Wait device, before termination
     // No check return value, because we want to terminate Vulkan
     vkDeviceWaitIdle(device);
 
     core.Destroy(device);
+    gpuProfiler.Destroy(device);
+
+    if (isHeadless) {
+        headlessInfo.readbackAllocator.Destroy(device);
+    }
 
     for (uint32_t i = 0U; i < FRAMES_IN_FLIGHT; i++) {
         vkDestroyCommandPool(device, commandBufferInfo.commandPools[i], nullptr);
@@ -598,6 +1251,11 @@ VulkanController::~VulkanController() {
         vkDestroySemaphore(device, commandBufferInfo.canRender[i], nullptr);
     }
 
+    vkDestroyCommandPool(device, uploadInfo.commandPool, nullptr);
+    vkDestroySemaphore(device, uploadInfo.isUploaded, nullptr);
+    vkDestroyCommandPool(device, asyncComputeInfo.commandPool, nullptr);
+    vkDestroySemaphore(device, asyncComputeInfo.timeline, nullptr);
+
     for (VkSemaphore &canPresent : swapchainInfo.canPresent) {
         vkDestroySemaphore(device, canPresent, nullptr);
     }
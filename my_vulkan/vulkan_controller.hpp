@@ -2,14 +2,33 @@
 
 #include <vulkan/vulkan_core.h>
 #include "core/core.hpp"
+#include "gpu_allocator.hpp"
+#include "gpu_profiler.hpp"
+#include "utils/camera.hpp"
+#include "utils/clock.hpp"
+#include "utils/job_system.hpp"
 #include <vector>
+#include <string>
 #include <array>
+#include <functional>
 
 namespace KRV {
 
 class VulkanController final {
 public:
-    VulkanController();
+    // Rendered frame in headless mode. Pixels are RGBA8 and valid only inside of the callback.
+    struct Frame final {
+        uint8_t const *pixels = nullptr;
+        VkExtent2D extent = {};
+        uint64_t index = 0ULL;
+    };
+
+    using FrameCallback = std::function<void(Frame const &)>;
+
+    // Headless controller doesn't use Window, surface and swapchain.
+    // Final image is copied into host visible memory and given to FrameCallback instead of presentation.
+    // Specialization constants retune shaders without their rebuild, defaults are taken from black_hole.in.
+    explicit VulkanController(bool isHeadless = false, BlackHoleSpecialization const &specialization = {});
 
     VulkanController(VulkanController const &) = delete;
     VulkanController& operator=(VulkanController const &) = delete;
@@ -18,11 +37,58 @@ public:
 
     ~VulkanController();
 
-    void DrawFrame();
+    void DrawFrame(Camera const &camera);
 
-protected:
-    static constexpr uint32_t FRAMES_IN_FLIGHT = 2U;
+    // Headless mode only. Frames are delivered FRAMES_IN_FLIGHT frames later, than they are drawn.
+    void SetFrameCallback(FrameCallback frameCallback);
+    // Wait for all submitted frames and deliver them
+    void FlushFrames();
+
+    // Switch render mode at runtime. All pipelines are already built, so it is cheap.
+    // Return value is false if the mode is not supported by the device.
+    bool SetRenderMode(RENDER_MODE renderMode);
+    RENDER_MODE GetRenderMode() const;
+
+    void SetRK45Tolerance(float tolerance);
+    float GetRK45Tolerance() const;
+
+    // Ray marching of 1 of factor pixels per frame, the rest are reprojected from the previous frame
+    bool SetInterleaveFactor(uint32_t factor);
+    uint32_t GetInterleaveFactor() const;
+
+    // Jittered samples with finer steps are accumulated while the camera is static
+    void SetProgressiveRefinement(bool isEnabled);
+    // Return value is true if DrawFrame of the camera would present the same image
+    bool IsConverged(Camera const &camera) const;
+
+    // Grid, wavefront or persistent threads dispatch of a ray marching mode
+    bool SetMarchingDispatch(RENDER_MODE renderMode, MARCHING_DISPATCH marchingDispatch);
+    MARCHING_DISPATCH GetMarchingDispatch(RENDER_MODE renderMode) const;
+
+    // Workgroup shape of a render mode. Frames in flight are waited, because the pipeline is rebuilt.
+    // Return value is false if the mode or the shape is not supported by the device.
+    bool SetWorkgroupSize(RENDER_MODE renderMode, VkExtent2D workgroupSize);
+    VkExtent2D GetWorkgroupSize(RENDER_MODE renderMode) const;
+
+    // Return value is false while the current mode is substituted, e.g. precomputed tables are still streamed
+    bool IsRenderModeReady() const;
+
+    // Render resolution and integration step follow GPU frame time, zero target disables it
+    void SetTargetFrameTime(double milliseconds);
+    double GetTargetFrameTime() const;
+
+    std::string GetDeviceName() const;
+    // Device UUID in hex and driver version identify results, which are measured on the device
+    std::string GetDeviceUUID() const;
+    uint32_t GetDriverVersion() const;
+
+    // Per-pass GPU time of the last completed frame
+    std::vector<Utils::GPUProfiler::ScopeTiming> const & GetGPUTimings() const;
 
+    // Milliseconds from construction until the first frame is completed on GPU, it is zero before that
+    double GetTimeToFirstFrame() const;
+
+protected:
     struct SwapchainInfo {
         VkSwapchainKHR swapchain = VK_NULL_HANDLE;
         std::vector<VkImage> images = {};
@@ -31,6 +97,17 @@ protected:
         VkExtent2D extent = {};
     };
 
+    struct HeadlessInfo {
+        Utils::GPUAllocator readbackAllocator{};
+        std::array<Buffer*, FRAMES_IN_FLIGHT> readbackBuffers{};
+        std::array<uint8_t*, FRAMES_IN_FLIGHT> mappedReadbackBuffers{};
+        std::array<bool, FRAMES_IN_FLIGHT> isFramePending{};
+        std::array<uint64_t, FRAMES_IN_FLIGHT> frameIndices{};
+        std::array<VkExtent2D, FRAMES_IN_FLIGHT> frameExtents{};
+        uint64_t frameCounter = 0ULL;
+        FrameCallback frameCallback{};
+    };
+
     struct CommandBufferInfo {
         std::array<VkCommandPool, FRAMES_IN_FLIGHT> commandPools;
         std::array<VkCommandBuffer, FRAMES_IN_FLIGHT> commandBuffers;
@@ -39,6 +116,37 @@ protected:
         uint32_t fif = 0U;
     };
 
+    // Assets are copied by a dedicated transfer queue, if the device has one. Only the first frame waits for them.
+    struct UploadInfo {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore isUploaded = VK_NULL_HANDLE;
+        bool isSubmitted = false;
+    };
+
+    // Precomputed tables are generated by an async compute queue, if the device has a compute family without graphics
+    // and timeline semaphores. Frames poll the timeline, so they never wait for the generation on CPU.
+    struct AsyncComputeInfo {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore timeline = VK_NULL_HANDLE;
+        uint64_t timelineValue = 0ULL;
+        bool isPending = false;
+    };
+
+    // Semaphores, which the submission of a frame waits for. Binary semaphores ignore their values.
+    struct SubmitWaits {
+        std::vector<VkSemaphore> semaphores{};
+        std::vector<VkPipelineStageFlags> stageMasks{};
+        std::vector<uint64_t> values{};
+
+        void Add(VkSemaphore semaphore, VkPipelineStageFlags stageMask, uint64_t value = 0ULL) {
+            semaphores.push_back(semaphore);
+            stageMasks.push_back(stageMask);
+            values.push_back(value);
+        }
+    };
+
     void InitInstance();
 #ifdef VULKAN_DEBUG_VALIDATION_LAYERS
     void InitDebugUtilsMessanger();
@@ -50,23 +158,62 @@ protected:
     void InitQueue();
     void InitSwapchain();
     void InitCommandBuffers();
+    void InitReadbackBuffers();
+    void InitUpload();
+    void InitAsyncCompute();
+
+    // Work of side queues is submitted before the frame is recorded, because recording depends on its state.
+    // Semaphores, which the frame must wait for, are added to waits.
+    void SubmitUpload(SubmitWaits &waits);
+    void SubmitAsyncCompute(SubmitWaits &waits);
+    // Signal semaphore is VK_NULL_HANDLE in headless mode
+    void SubmitFrame(SubmitWaits const &waits, VkSemaphore signalSemaphore, uint32_t fif);
+
+    void RecordCommandBuffer(VkImage swapchainImage, uint32_t fif, Camera const &camera);
+    void RecordFinalBlit(VkCommandBuffer commandBuffer, Image &finalImage, VkImage swapchainImage);
+    void RecordFinalCopy(VkCommandBuffer commandBuffer, Image &finalImage, uint32_t fif);
+
+    void DrawFrameHeadless(Camera const &camera);
+    void MeasureTimeToFirstFrame(uint32_t fif);
+    void DeliverFrame(uint32_t fif);
 
-    void RecordCommandBuffer(VkImage swapchainImage, uint32_t fif);
+    // It is the first member, so it starts before any initialization
+    Clock startupClock{};
+    double timeToFirstFrameMs = 0.0;
 
+    bool isHeadless = false;
     VkInstance instance = VK_NULL_HANDLE;
 #ifdef VULKAN_DEBUG_VALIDATION_LAYERS
     VkDebugUtilsMessengerCreateInfoEXT debugUtilsMessengerCI;
     VkDebugUtilsMessengerEXT debugUtilsMessenger = VK_NULL_HANDLE;
 #endif // VULKAN_DEBUG_VALIDATION_LAYERS
     VkSurfaceKHR surface = VK_NULL_HANDLE;
+    // Requested by the instance, and then lowered to the version of the physical device
+    uint32_t apiVersion = VK_API_VERSION_1_0;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice device = VK_NULL_HANDLE;
+    bool isRayQuerySupported = false;
+    bool isPrecomputedSupported = true;
     uint32_t queueFamilyIndex = 0U;
     VkQueue queue = VK_NULL_HANDLE;
+    // It is the same as queueFamilyIndex, if there is no transfer-only queue family
+    uint32_t transferQueueFamilyIndex = 0U;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    // It is the same as queueFamilyIndex, if async compute is not supported
+    uint32_t computeQueueFamilyIndex = 0U;
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    bool isTimelineSemaphoreSupported = false;
     SwapchainInfo swapchainInfo = {};
     CommandBufferInfo commandBufferInfo = {};
+    UploadInfo uploadInfo = {};
+    AsyncComputeInfo asyncComputeInfo = {};
+    HeadlessInfo headlessInfo = {};
+    Utils::GPUProfiler gpuProfiler{};
 
     Core core{};
+    // Startup work: decoding of files, pipeline compilation and initialization of passes.
+    // It is declared after core, so queued jobs are finished before core is destroyed.
+    JobSystem jobSystem{};
 };
 
 }
@@ -41,6 +41,8 @@ void LoadVulkanGlobalFunctions() {
 #define X(name) if (name = reinterpret_cast<decltype(name)>(vkGetInstanceProcAddr(nullptr, #name)); name == nullptr) {throw std::runtime_error(std::format("Cannot Load Global Vulkan Function: {}", #name));}
 #include "vulkan_functions/global.in"
 #undef X
+
+    vkEnumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
 }
 
 void LoadVulkanInstanceFunctions(VkInstance instance) {
@@ -49,10 +51,28 @@ void LoadVulkanInstanceFunctions(VkInstance instance) {
 #undef X
 }
 
+void LoadVulkan11InstanceFunctions(VkInstance instance) {
+#define X(name) if (name = reinterpret_cast<decltype(name)>(vkGetInstanceProcAddr(instance, #name)); name == nullptr) {throw std::runtime_error(std::format("Cannot Load Vulkan 1.1 Instance Function: {}", #name));}
+#include "vulkan_functions/instance_1_1.in"
+#undef X
+}
+
 void LoadVulkanDeviceFunctions(VkDevice device) {
 #define X(name) if (name = reinterpret_cast<decltype(name)>(vkGetDeviceProcAddr(device, #name)); name == nullptr) {throw std::runtime_error(std::format("Cannot Load Device Vulkan Function: {}", #name));}
 #include "vulkan_functions/device.in"
 #undef X
 }
 
+void LoadVulkanRayQueryDeviceFunctions(VkDevice device) {
+#define X(name) if (name = reinterpret_cast<decltype(name)>(vkGetDeviceProcAddr(device, #name)); name == nullptr) {throw std::runtime_error(std::format("Cannot Load Ray Query Device Vulkan Function: {}", #name));}
+#include "vulkan_functions/device_ray_query.in"
+#undef X
+}
+
+void LoadVulkanTimelineSemaphoreDeviceFunctions(VkDevice device) {
+#define X(name) if (name = reinterpret_cast<decltype(name)>(vkGetDeviceProcAddr(device, #name)); name == nullptr) {throw std::runtime_error(std::format("Cannot Load Timeline Semaphore Device Vulkan Function: {}", #name));}
+#include "vulkan_functions/device_timeline_semaphore.in"
+#undef X
+}
+
 }
\ No newline at end of file
@@ -2,15 +2,23 @@
 
 #define X(name) inline PFN_##name name = nullptr;
 inline PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = nullptr;
+// It is nullptr for Vulkan 1.0 loaders
+inline PFN_vkEnumerateInstanceVersion vkEnumerateInstanceVersion = nullptr;
 #include "vulkan_functions/global.in"
 #include "vulkan_functions/instance.in"
+#include "vulkan_functions/instance_1_1.in"
 #include "vulkan_functions/device.in"
+#include "vulkan_functions/device_ray_query.in"
+#include "vulkan_functions/device_timeline_semaphore.in"
 #undef X
 
 namespace KRV {
 
 void LoadVulkanGlobalFunctions();
 void LoadVulkanInstanceFunctions(VkInstance instance);
+void LoadVulkan11InstanceFunctions(VkInstance instance);
 void LoadVulkanDeviceFunctions(VkDevice device);
+void LoadVulkanRayQueryDeviceFunctions(VkDevice device);
+void LoadVulkanTimelineSemaphoreDeviceFunctions(VkDevice device);
 
 }
\ No newline at end of file
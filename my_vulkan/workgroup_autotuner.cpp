@@ -0,0 +1,205 @@
+#include "workgroup_autotuner.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// GPU scope of render mode dispatches, other passes don't depend on the workgroup shape
+constexpr char const *measuredScopeName = "BlackHolePass";
+
+}
+
+namespace KRV {
+
+WorkgroupAutotuner::WorkgroupAutotuner(std::string fileName) : fileName(std::move(fileName)) {
+    // Close approach covers both far rays and rays near the photon sphere
+    path = CameraPath::FromScenario(CameraPath::SCENARIO::CLOSE_APPROACH, MEASURED_FRAMES);
+    Load();
+}
+
+void WorkgroupAutotuner::Apply(VulkanController &vulkanController, TUNING tuning) {
+    std::string const deviceUUID = vulkanController.GetDeviceUUID();
+    uint32_t const driverVersion = vulkanController.GetDriverVersion();
+
+    RENDER_MODE const initialRenderMode = vulkanController.GetRenderMode();
+    double const initialTargetFrameTime = vulkanController.GetTargetFrameTime();
+    bool isChanged = false;
+
+    for (uint32_t modeIdx = 0U; modeIdx < RENDER_MODE_COUNT; modeIdx++) {
+        auto const renderMode = static_cast<RENDER_MODE>(modeIdx);
+        std::string const renderModeName = GetRenderModeName(renderMode);
+
+        auto const it = std::ranges::find_if(entries, [&](Entry const &entry){
+            return entry.deviceUUID == deviceUUID && entry.driverVersion == driverVersion && entry.renderMode == renderModeName;
+        });
+
+        if (it != entries.end() && tuning != TUNING::ALL) {
+            vulkanController.SetWorkgroupSize(renderMode, it->workgroupSize);
+            continue;
+        }
+
+        if (tuning == TUNING::NONE || !PrepareRenderMode(vulkanController, renderMode)) {
+            continue;
+        }
+
+        // Frame time governor would change the render extent between candidates
+        vulkanController.SetTargetFrameTime(0.0);
+
+        VkExtent2D bestWorkgroupSize = vulkanController.GetWorkgroupSize(renderMode);
+        double bestMs = 0.0;
+        for (VkExtent2D const &workgroupSize : CANDIDATES) {
+            if (!vulkanController.SetWorkgroupSize(renderMode, workgroupSize)) {
+                continue;
+            }
+
+            double const ms = MeasureDispatches(vulkanController, renderMode);
+            if (ms <= 0.0) {
+                std::cerr << "[WorkgroupAutotuner] GPU timestamps are not supported, workgroup shapes are not tuned\n";
+                vulkanController.SetWorkgroupSize(renderMode, bestWorkgroupSize);
+                vulkanController.SetRenderMode(initialRenderMode);
+                vulkanController.SetTargetFrameTime(initialTargetFrameTime);
+                return;
+            }
+
+            if (bestMs == 0.0 || ms < bestMs) {
+                bestMs = ms;
+                bestWorkgroupSize = workgroupSize;
+            }
+        }
+
+        vulkanController.SetWorkgroupSize(renderMode, bestWorkgroupSize);
+        std::cout << std::format("[WorkgroupAutotuner] {}: {}x{} ({:.3f} ms)", renderModeName,
+            bestWorkgroupSize.width, bestWorkgroupSize.height, bestMs) << std::endl;
+
+        Entry const entry {
+            .deviceUUID = deviceUUID,
+            .driverVersion = driverVersion,
+            .renderMode = renderModeName,
+            .workgroupSize = bestWorkgroupSize
+        };
+
+        if (it != entries.end()) {
+            *it = entry;
+        } else {
+            entries.push_back(entry);
+        }
+        isChanged = true;
+    }
+
+    vulkanController.SetRenderMode(initialRenderMode);
+    vulkanController.SetTargetFrameTime(initialTargetFrameTime);
+
+    if (isChanged) {
+        Save();
+    }
+}
+
+void WorkgroupAutotuner::Load() {
+    // Missing file is not an error, all modes are tuned then
+    std::ifstream file(fileName);
+
+    Entry entry{};
+    while (file >> entry.deviceUUID >> entry.driverVersion >> entry.renderMode >> entry.workgroupSize.width >> entry.workgroupSize.height) {
+        entries.push_back(entry);
+    }
+}
+
+void WorkgroupAutotuner::Save() const {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << std::format("[WorkgroupAutotuner] Cannot write file {}\n", fileName);
+        return;
+    }
+
+    // Entries of other devices and drivers are kept
+    for (auto const &entry : entries) {
+        file << std::format("{} {} {} {} {}\n", entry.deviceUUID, entry.driverVersion, entry.renderMode,
+            entry.workgroupSize.width, entry.workgroupSize.height);
+    }
+}
+
+bool WorkgroupAutotuner::PrepareRenderMode(VulkanController &vulkanController, RENDER_MODE renderMode) {
+    if (!vulkanController.SetRenderMode(renderMode)) {
+        return false;
+    }
+
+    Camera camera(glm::vec3(1.0F), glm::vec3(-1.0F), 0.0F, 0.0F, 1.57F);
+    for (uint32_t i = 0U; i < MAX_PREPARATION_FRAMES && !vulkanController.IsRenderModeReady(); i++) {
+        auto const &pose = path.GetPose(i);
+        camera.SetPose(pose.position, pose.direction);
+        vulkanController.DrawFrame(camera);
+    }
+
+    if (!vulkanController.IsRenderModeReady()) {
+        std::cerr << std::format("[WorkgroupAutotuner] Render mode {} is not ready, its workgroup shape is not tuned\n",
+            GetRenderModeName(renderMode));
+        return false;
+    }
+
+    return true;
+}
+
+double WorkgroupAutotuner::MeasureDispatches(VulkanController &vulkanController, RENDER_MODE renderMode) {
+    if (!IsRayMarchingMode(renderMode)) {
+        return Measure(vulkanController);
+    }
+
+    MARCHING_DISPATCH const initialMarchingDispatch = vulkanController.GetMarchingDispatch(renderMode);
+
+    double sumMs = 0.0;
+    for (uint32_t dispatchIdx = 0U; dispatchIdx < MARCHING_DISPATCH_COUNT; dispatchIdx++) {
+        vulkanController.SetMarchingDispatch(renderMode, static_cast<MARCHING_DISPATCH>(dispatchIdx));
+
+        double const ms = Measure(vulkanController);
+        if (ms <= 0.0) {
+            sumMs = 0.0;
+            break;
+        }
+        sumMs += ms;
+    }
+
+    vulkanController.SetMarchingDispatch(renderMode, initialMarchingDispatch);
+
+    return sumMs;
+}
+
+double WorkgroupAutotuner::Measure(VulkanController &vulkanController) {
+    // Camera moves every frame, so progressive refinement doesn't change the cost of frames
+    Camera camera(glm::vec3(1.0F), glm::vec3(-1.0F), 0.0F, 0.0F, 1.57F);
+
+    // Warmup also covers frames in flight, whose timings belong to the previous shape
+    for (uint32_t i = 0U; i < WARMUP_FRAMES; i++) {
+        auto const &pose = path.GetPose(i);
+        camera.SetPose(pose.position, pose.direction);
+        vulkanController.DrawFrame(camera);
+    }
+
+    std::vector<double> frameTimesMs;
+    frameTimesMs.reserve(MEASURED_FRAMES);
+    for (uint32_t i = 0U; i < MEASURED_FRAMES; i++) {
+        auto const &pose = path.GetPose(i);
+        camera.SetPose(pose.position, pose.direction);
+        vulkanController.DrawFrame(camera);
+
+        auto const &timings = vulkanController.GetGPUTimings();
+        auto const it = std::ranges::find(timings, measuredScopeName, &Utils::GPUProfiler::ScopeTiming::name);
+        if (it != timings.end()) {
+            frameTimesMs.push_back(it->milliseconds);
+        }
+    }
+
+    if (frameTimesMs.empty()) {
+        return 0.0;
+    }
+
+    auto const median = frameTimesMs.begin() + frameTimesMs.size()/2U;
+    std::ranges::nth_element(frameTimesMs, median);
+    return *median;
+}
+
+}
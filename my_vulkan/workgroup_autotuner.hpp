@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vulkan_controller.hpp"
+#include "utils/camera_path.hpp"
+
+#include <string>
+#include <vector>
+
+namespace KRV {
+
+// Workgroup shape of every render mode is tuned per device: pipelines of candidate shapes are timed by GPU timestamps
+// on a short scripted camera path. Winners are saved into a text file keyed by device UUID, driver version and mode.
+class WorkgroupAutotuner final {
+public:
+    static constexpr VkExtent2D CANDIDATES[] = {
+        {8U, 8U},
+        {16U, 8U},
+        {16U, 16U},
+        {32U, 4U},
+        {32U, 8U},
+        {64U, 1U}
+    };
+
+    // Tuning takes hundreds of frames per mode, so it runs only on explicit request
+    enum class TUNING {
+        NONE,    // Saved shapes are applied, other modes keep default shapes
+        MISSING, // Modes without saved shapes are tuned
+        ALL      // Every supported mode is tuned again
+    };
+
+    explicit WorkgroupAutotuner(std::string fileName);
+
+    WorkgroupAutotuner(WorkgroupAutotuner const &) = delete;
+    WorkgroupAutotuner& operator=(WorkgroupAutotuner const &) = delete;
+    WorkgroupAutotuner(WorkgroupAutotuner &&) = delete;
+    WorkgroupAutotuner& operator=(WorkgroupAutotuner &&) = delete;
+
+    ~WorkgroupAutotuner() = default;
+
+    // Saved shapes of the device are applied, tuned shapes are saved
+    void Apply(VulkanController &vulkanController, TUNING tuning);
+
+private:
+    // Text format: one entry per line, "deviceUUID driverVersion MODE width height"
+    struct Entry final {
+        std::string deviceUUID = "";
+        uint32_t driverVersion = 0U;
+        std::string renderMode = "";
+        VkExtent2D workgroupSize = {};
+    };
+
+    static constexpr uint32_t WARMUP_FRAMES = 8U;
+    static constexpr uint32_t MEASURED_FRAMES = 24U;
+    // Precomputed tables are generated by slices or streamed from their cache before the mode is measured
+    static constexpr uint32_t MAX_PREPARATION_FRAMES = 16384U;
+
+    void Load();
+    void Save() const;
+
+    bool PrepareRenderMode(VulkanController &vulkanController, RENDER_MODE renderMode);
+    // Sum of Measure over marching dispatches, all of them share the pipeline of the mode
+    double MeasureDispatches(VulkanController &vulkanController, RENDER_MODE renderMode);
+    // Median GPU time of the black hole pass, it is zero if timestamps are not supported
+    double Measure(VulkanController &vulkanController);
+
+    std::string fileName = "";
+    std::vector<Entry> entries{};
+    CameraPath path{};
+};
+
+}
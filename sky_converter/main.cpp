@@ -0,0 +1,217 @@
+#include "utils/bc_encoder.hpp"
+#include "utils/job_system.hpp"
+#include "utils/ktx2.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "third-party/stb_image.h"
+
+// Offline converter of sky cube map faces into KTX 2.0 container with block compressed mip levels.
+// BC7 keeps LDR faces, BC6H keeps HDR ones (e.g. `.hdr` files). Values of LDR files are taken as linear ones,
+// like the renderer does with RGBA8 faces. Faces are listed in the order of cube map layers.
+// Usage: sky_converter [--format BC7|BC6H] [--output sky.ktx2] [left right bottom top back front]
+
+namespace {
+
+constexpr uint32_t facesNum = KRV::KTX2CubeMap::FACES_NUM;
+constexpr uint32_t channelsNum = 4U;
+
+struct Options final {
+    KRV::KTX2CubeMap::Format format = KRV::KTX2CubeMap::Format::BC7_UNORM;
+    std::string output = "textures/black_hole/sky.ktx2";
+    std::array<std::string, facesNum> faces = {
+        "textures/black_hole/left.png",
+        "textures/black_hole/right.png",
+        "textures/black_hole/bottom.png",
+        "textures/black_hole/top.png",
+        "textures/black_hole/back.png",
+        "textures/black_hole/front.png"
+    };
+};
+
+// RGBA float texels of a square mip level
+struct Image final {
+    uint32_t dimension = 0U;
+    std::vector<float> texels{};
+};
+
+Options ParseOptions(int argc, char **argv) {
+    Options options{};
+    std::vector<std::string> faces{};
+
+    for (int i = 1; i < argc; i++) {
+        auto const nextArg = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::runtime_error(std::format("Missing value of argument {}", argv[i]));
+            }
+            return argv[++i];
+        };
+
+        if (std::strcmp(argv[i], "--format") == 0) {
+            std::string const format = nextArg();
+            if (format == "BC7") {
+                options.format = KRV::KTX2CubeMap::Format::BC7_UNORM;
+            } else if (format == "BC6H") {
+                options.format = KRV::KTX2CubeMap::Format::BC6H_UFLOAT;
+            } else {
+                throw std::runtime_error(std::format("Unknown format {}", format));
+            }
+        } else if (std::strcmp(argv[i], "--output") == 0) {
+            options.output = nextArg();
+        } else if (std::strncmp(argv[i], "--", 2U) == 0) {
+            throw std::runtime_error(std::format("Unknown argument {}", argv[i]));
+        } else {
+            faces.emplace_back(argv[i]);
+        }
+    }
+
+    if (!faces.empty()) {
+        if (faces.size() != facesNum) {
+            throw std::runtime_error(std::format("Expected {} faces, but {} are given", facesNum, faces.size()));
+        }
+        std::ranges::move(faces, options.faces.begin());
+    }
+
+    return options;
+}
+
+Image LoadFace(std::string const &fileName) {
+    int x = 0, y = 0, channels = 0;
+    std::unique_ptr<float, void(*)(void*)> const pixels(stbi_loadf(fileName.c_str(), &x, &y, &channels, STBI_rgb_alpha), stbi_image_free);
+    if (!pixels) {
+        throw std::runtime_error(std::format("[SkyConverter] Cannot decode {}", fileName));
+    }
+
+    auto const dimension = static_cast<uint32_t>(x);
+    if (x != y || !std::has_single_bit(dimension)) {
+        throw std::runtime_error(std::format("[SkyConverter] Face {} is not a square with power of two size", fileName));
+    }
+
+    return {
+        .dimension = dimension,
+        .texels = {pixels.get(), pixels.get() + static_cast<size_t>(dimension)*dimension*channelsNum}
+    };
+}
+
+// Box filter of 2x2 texels, the same as linear blits of mip generation
+Image Downsample(Image const &image) {
+    Image result {
+        .dimension = image.dimension/2U,
+        .texels = std::vector<float>(static_cast<size_t>(image.dimension/2U)*(image.dimension/2U)*channelsNum)
+    };
+
+    for (uint32_t y = 0U; y < result.dimension; y++) {
+        for (uint32_t x = 0U; x < result.dimension; x++) {
+            for (uint32_t c = 0U; c < channelsNum; c++) {
+                auto const texel = [&](uint32_t dx, uint32_t dy){
+                    return image.texels[((2U*y + dy)*image.dimension + 2U*x + dx)*channelsNum + c];
+                };
+                result.texels[(y*result.dimension + x)*channelsNum + c] = 0.25F*(texel(0U, 0U) + texel(1U, 0U) + texel(0U, 1U) + texel(1U, 1U));
+            }
+        }
+    }
+
+    return result;
+}
+
+// Levels smaller than a block repeat their border texels
+void EncodeBlockRow(Image const &image, KRV::KTX2CubeMap::Format format, uint32_t blockRow, uint8_t *blocks) {
+    uint32_t const blocksNum = (image.dimension + KRV::BC_BLOCK_DIMENSION - 1U)/KRV::BC_BLOCK_DIMENSION;
+
+    for (uint32_t blockColumn = 0U; blockColumn < blocksNum; blockColumn++, blocks += KRV::BC_BLOCK_BYTES) {
+        std::array<uint8_t, KRV::BC_BLOCK_TEXELS*channelsNum> unorms{};
+        std::array<float, KRV::BC_BLOCK_TEXELS*3U> floats{};
+
+        for (uint32_t i = 0U; i < KRV::BC_BLOCK_TEXELS; i++) {
+            uint32_t const x = std::min(blockColumn*KRV::BC_BLOCK_DIMENSION + i%KRV::BC_BLOCK_DIMENSION, image.dimension - 1U);
+            uint32_t const y = std::min(blockRow*KRV::BC_BLOCK_DIMENSION + i/KRV::BC_BLOCK_DIMENSION, image.dimension - 1U);
+            float const *texel = &image.texels[(y*image.dimension + x)*channelsNum];
+
+            for (uint32_t c = 0U; c < channelsNum; c++) {
+                unorms[i*channelsNum + c] = static_cast<uint8_t>(std::lround(std::clamp(texel[c], 0.0F, 1.0F)*255.0F));
+            }
+            std::copy_n(texel, 3U, &floats[i*3U]);
+        }
+
+        if (format == KRV::KTX2CubeMap::Format::BC7_UNORM) {
+            KRV::EncodeBC7Block(unorms.data(), blocks);
+        } else {
+            KRV::EncodeBC6HBlock(floats.data(), blocks);
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    try {
+        Options const options = ParseOptions(argc, argv);
+
+        // LDR files are converted into floats without sRGB decoding
+        stbi_ldr_to_hdr_gamma(1.0F);
+
+        KRV::JobSystem jobSystem{};
+
+        // Every face is decoded and filtered by its own job
+        std::array<std::vector<Image>, facesNum> mipChains{};
+        KRV::JobSystem::Group mipGroup{};
+        for (uint32_t faceIdx = 0U; faceIdx < facesNum; faceIdx++) {
+            jobSystem.Submit(mipGroup, [&options, &mipChains, faceIdx](){
+                auto &mipChain = mipChains[faceIdx];
+                mipChain.push_back(LoadFace(options.faces[faceIdx]));
+                while (mipChain.back().dimension > 1U) {
+                    mipChain.push_back(Downsample(mipChain.back()));
+                }
+            });
+        }
+        jobSystem.Wait(mipGroup);
+
+        uint32_t const dimension = mipChains[0].front().dimension;
+        for (uint32_t faceIdx = 1U; faceIdx < facesNum; faceIdx++) {
+            if (mipChains[faceIdx].front().dimension != dimension) {
+                throw std::runtime_error(std::format("[SkyConverter] Face {} has another size", options.faces[faceIdx]));
+            }
+        }
+
+        // Rows of blocks are encoded independently, so even the biggest level is shared by all workers
+        uint32_t const levelsNum = static_cast<uint32_t>(mipChains[0].size());
+        std::vector<std::vector<uint8_t>> levels(levelsNum);
+        KRV::JobSystem::Group encodeGroup{};
+        for (uint32_t levelIdx = 0U; levelIdx < levelsNum; levelIdx++) {
+            levels[levelIdx].resize(KRV::KTX2CubeMap::GetLevelSize(dimension, levelIdx));
+            size_t const faceSize = levels[levelIdx].size()/facesNum;
+            uint32_t const blocksNum = (std::max(dimension >> levelIdx, 1U) + KRV::BC_BLOCK_DIMENSION - 1U)/KRV::BC_BLOCK_DIMENSION;
+
+            for (uint32_t faceIdx = 0U; faceIdx < facesNum; faceIdx++) {
+                for (uint32_t blockRow = 0U; blockRow < blocksNum; blockRow++) {
+                    uint8_t *blocks = levels[levelIdx].data() + faceIdx*faceSize + blockRow*blocksNum*KRV::BC_BLOCK_BYTES;
+                    jobSystem.Submit(encodeGroup, [&options, &image = mipChains[faceIdx][levelIdx], blockRow, blocks](){
+                        EncodeBlockRow(image, options.format, blockRow, blocks);
+                    });
+                }
+            }
+        }
+        jobSystem.Wait(encodeGroup);
+
+        KRV::KTX2CubeMap::Write(options.output, options.format, dimension, levels);
+
+        bool const isBC7 = (options.format == KRV::KTX2CubeMap::Format::BC7_UNORM);
+        std::cout << std::format("[SkyConverter] {} is written: {}x{}, {} levels, {}", options.output, dimension, dimension,
+            levelsNum, isBC7 ? "BC7" : "BC6H") << std::endl;
+    } catch (std::exception const &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
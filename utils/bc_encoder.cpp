@@ -0,0 +1,416 @@
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Interpolation weights of 4-bit indices, they are the same for BC7 and BC6H
+constexpr uint32_t weights4[KRV::BC_BLOCK_TEXELS] = {0U, 4U, 9U, 13U, 17U, 21U, 26U, 30U, 34U, 38U, 43U, 47U, 51U, 55U, 60U, 64U};
+constexpr uint32_t indexMax = KRV::BC_BLOCK_TEXELS - 1U;
+// The first index has no top bit, so it must be in the lower half of indices
+constexpr uint32_t anchorIndexBit = 8U;
+
+// Endpoints are refined by least squares over the chosen indices
+constexpr uint32_t refinementsNum = 2U;
+
+// The biggest finite unsigned half float, 65504.0
+constexpr uint32_t halfMax = 0x7BFFU;
+
+template<size_t C>
+using Texel = std::array<float, C>;
+
+template<size_t C>
+using Texels = std::array<Texel<C>, KRV::BC_BLOCK_TEXELS>;
+
+// Bits are written from the least significant bit of the block
+class BlockWriter final {
+public:
+    explicit BlockWriter(uint8_t *block) : block(block) {
+        std::memset(block, 0, KRV::BC_BLOCK_BYTES);
+    }
+
+    void Write(uint32_t value, uint32_t bitsNum) {
+        for (uint32_t i = 0U; i < bitsNum; i++, bitIdx++) {
+            block[bitIdx/8U] |= static_cast<uint8_t>(((value >> i) & 1U) << (bitIdx % 8U));
+        }
+    }
+
+private:
+    uint8_t *block = nullptr;
+    uint32_t bitIdx = 0U;
+};
+
+// Endpoints of the line through texels along their principal axis
+template<size_t C>
+void FitLine(Texels<C> const &texels, Texel<C> &endpoint0, Texel<C> &endpoint1) {
+    Texel<C> mean{};
+    for (auto const &texel : texels) {
+        for (size_t c = 0U; c < C; c++) {
+            mean[c] += texel[c]/KRV::BC_BLOCK_TEXELS;
+        }
+    }
+
+    std::array<Texel<C>, C> covariance{};
+    for (auto const &texel : texels) {
+        for (size_t i = 0U; i < C; i++) {
+            for (size_t j = 0U; j < C; j++) {
+                covariance[i][j] += (texel[i] - mean[i])*(texel[j] - mean[j]);
+            }
+        }
+    }
+
+    // Power iteration converges in a few steps for 3 or 4 dimensions
+    Texel<C> axis{};
+    axis.fill(1.0F);
+    for (uint32_t iteration = 0U; iteration < 8U; iteration++) {
+        Texel<C> next{};
+        for (size_t i = 0U; i < C; i++) {
+            for (size_t j = 0U; j < C; j++) {
+                next[i] += covariance[i][j]*axis[j];
+            }
+        }
+
+        float lengthSquared = 0.0F;
+        for (float x : next) {
+            lengthSquared += x*x;
+        }
+
+        float const length = std::sqrt(lengthSquared);
+        if (length < std::numeric_limits<float>::epsilon()) {
+            // All texels are the same
+            endpoint0 = mean;
+            endpoint1 = mean;
+            return;
+        }
+
+        for (size_t i = 0U; i < C; i++) {
+            axis[i] = next[i]/length;
+        }
+    }
+
+    float minProjection = std::numeric_limits<float>::max();
+    float maxProjection = std::numeric_limits<float>::lowest();
+    for (auto const &texel : texels) {
+        float projection = 0.0F;
+        for (size_t c = 0U; c < C; c++) {
+            projection += (texel[c] - mean[c])*axis[c];
+        }
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    for (size_t c = 0U; c < C; c++) {
+        endpoint0[c] = mean[c] + minProjection*axis[c];
+        endpoint1[c] = mean[c] + maxProjection*axis[c];
+    }
+}
+
+// Least squares endpoints of chosen indices. Return value is false if indices don't define a line.
+template<size_t C>
+bool RefineEndpoints(Texels<C> const &texels, std::array<uint32_t, KRV::BC_BLOCK_TEXELS> const &indices,
+    Texel<C> &endpoint0, Texel<C> &endpoint1) {
+    float a00 = 0.0F, a01 = 0.0F, a11 = 0.0F;
+    Texel<C> b0{}, b1{};
+    for (uint32_t i = 0U; i < KRV::BC_BLOCK_TEXELS; i++) {
+        float const w = static_cast<float>(weights4[indices[i]])/64.0F;
+        a00 += (1.0F - w)*(1.0F - w);
+        a01 += (1.0F - w)*w;
+        a11 += w*w;
+        for (size_t c = 0U; c < C; c++) {
+            b0[c] += (1.0F - w)*texels[i][c];
+            b1[c] += w*texels[i][c];
+        }
+    }
+
+    float const determinant = a00*a11 - a01*a01;
+    if (std::abs(determinant) < 1.0e-6F) {
+        return false;
+    }
+
+    for (size_t c = 0U; c < C; c++) {
+        endpoint0[c] = (a11*b0[c] - a01*b1[c])/determinant;
+        endpoint1[c] = (a00*b1[c] - a01*b0[c])/determinant;
+    }
+
+    return true;
+}
+
+// Palette of quantized endpoints is searched for the closest entry of every texel
+template<size_t C>
+float ChooseIndices(Texels<C> const &texels, std::array<Texel<C>, KRV::BC_BLOCK_TEXELS> const &palette,
+    std::array<uint32_t, KRV::BC_BLOCK_TEXELS> &indices) {
+    float error = 0.0F;
+    for (uint32_t i = 0U; i < KRV::BC_BLOCK_TEXELS; i++) {
+        float bestError = std::numeric_limits<float>::max();
+        for (uint32_t idx = 0U; idx <= indexMax; idx++) {
+            float texelError = 0.0F;
+            for (size_t c = 0U; c < C; c++) {
+                float const d = texels[i][c] - palette[idx][c];
+                texelError += d*d;
+            }
+
+            if (texelError < bestError) {
+                bestError = texelError;
+                indices[i] = idx;
+            }
+        }
+        error += bestError;
+    }
+
+    return error;
+}
+
+uint32_t Interpolate(uint32_t e0, uint32_t e1, uint32_t idx) {
+    return ((64U - weights4[idx])*e0 + weights4[idx]*e1 + 32U) >> 6U;
+}
+
+////////////////////////////////////////// BC7 //////////////////////////////////////////
+
+// Mode 6: 7-bit RGBA endpoints with a shared lowest bit (p-bit) per endpoint
+struct BC7Endpoints final {
+    std::array<uint32_t, 4U> e0{};
+    std::array<uint32_t, 4U> e1{};
+    uint32_t p0 = 0U;
+    uint32_t p1 = 0U;
+};
+
+uint32_t QuantizeBC7(float value, uint32_t pBit) {
+    float const q = std::round((std::clamp(value, 0.0F, 255.0F) - static_cast<float>(pBit))/2.0F);
+    return static_cast<uint32_t>(std::clamp(q, 0.0F, 127.0F));
+}
+
+float EncodeBC7Endpoints(Texels<4U> const &texels, Texel<4U> const &endpoint0, Texel<4U> const &endpoint1,
+    BC7Endpoints &endpoints, std::array<uint32_t, KRV::BC_BLOCK_TEXELS> &indices) {
+    float bestError = std::numeric_limits<float>::max();
+
+    for (uint32_t pBits = 0U; pBits < 4U; pBits++) {
+        BC7Endpoints candidate {
+            .p0 = pBits & 1U,
+            .p1 = pBits >> 1U
+        };
+
+        std::array<Texel<4U>, KRV::BC_BLOCK_TEXELS> palette{};
+        for (uint32_t c = 0U; c < 4U; c++) {
+            candidate.e0[c] = QuantizeBC7(endpoint0[c], candidate.p0);
+            candidate.e1[c] = QuantizeBC7(endpoint1[c], candidate.p1);
+
+            uint32_t const value0 = (candidate.e0[c] << 1U) | candidate.p0;
+            uint32_t const value1 = (candidate.e1[c] << 1U) | candidate.p1;
+            for (uint32_t idx = 0U; idx <= indexMax; idx++) {
+                palette[idx][c] = static_cast<float>(Interpolate(value0, value1, idx));
+            }
+        }
+
+        std::array<uint32_t, KRV::BC_BLOCK_TEXELS> candidateIndices{};
+        float const error = ChooseIndices(texels, palette, candidateIndices);
+        if (error < bestError) {
+            bestError = error;
+            endpoints = candidate;
+            indices = candidateIndices;
+        }
+    }
+
+    return bestError;
+}
+
+////////////////////////////////////////// BC6H //////////////////////////////////////////
+
+constexpr uint32_t bc6hEndpointBits = 10U;
+constexpr uint32_t bc6hEndpointMax = (1U << bc6hEndpointBits) - 1U;
+
+// Bits of a non-negative half float, the value is rounded to the nearest one
+uint32_t FloatToHalfBits(float value) {
+    value = std::clamp(value, 0.0F, 65504.0F);
+    uint32_t const bits = std::bit_cast<uint32_t>(value);
+    int32_t const exponent = static_cast<int32_t>((bits >> 23U) & 0xFFU) - 127 + 15;
+    uint32_t const mantissa = bits & 0x7FFFFFU;
+
+    // Subnormal half floats
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return 0U;
+        }
+
+        uint32_t const shift = static_cast<uint32_t>(14 - exponent);
+        return ((mantissa | 0x800000U) + (1U << (shift - 1U))) >> shift;
+    }
+
+    uint32_t const half = (static_cast<uint32_t>(exponent) << 10U) | (mantissa >> 13U);
+    return std::min(half + ((mantissa >> 12U) & 1U), halfMax);
+}
+
+// Endpoint into the 16-bit interpolation domain of unsigned BC6H
+uint32_t UnquantizeBC6H(uint32_t endpoint) {
+    if (endpoint == 0U) {
+        return 0U;
+    }
+    if (endpoint == bc6hEndpointMax) {
+        return 0xFFFFU;
+    }
+    return ((endpoint << 16U) + 0x8000U) >> bc6hEndpointBits;
+}
+
+// Interpolated value into half float bits
+uint32_t FinishUnquantizeBC6H(uint32_t value) {
+    return (value*31U) >> 6U;
+}
+
+// Endpoint, which is decoded to the closest half float bits
+uint32_t QuantizeBC6H(float halfBits) {
+    auto const candidate = static_cast<int32_t>(std::round(std::clamp(halfBits, 0.0F, static_cast<float>(halfMax))/31.0F - 0.5F));
+
+    uint32_t bestEndpoint = 0U;
+    float bestError = std::numeric_limits<float>::max();
+    for (int32_t endpoint = candidate - 1; endpoint <= candidate + 1; endpoint++) {
+        uint32_t const clamped = static_cast<uint32_t>(std::clamp(endpoint, 0, static_cast<int32_t>(bc6hEndpointMax)));
+        float const error = std::abs(static_cast<float>(FinishUnquantizeBC6H(UnquantizeBC6H(clamped))) - halfBits);
+        if (error < bestError) {
+            bestError = error;
+            bestEndpoint = clamped;
+        }
+    }
+
+    return bestEndpoint;
+}
+
+float EncodeBC6HEndpoints(Texels<3U> const &texels, Texel<3U> const &endpoint0, Texel<3U> const &endpoint1,
+    std::array<uint32_t, 3U> &e0, std::array<uint32_t, 3U> &e1, std::array<uint32_t, KRV::BC_BLOCK_TEXELS> &indices) {
+    std::array<Texel<3U>, KRV::BC_BLOCK_TEXELS> palette{};
+    for (uint32_t c = 0U; c < 3U; c++) {
+        e0[c] = QuantizeBC6H(endpoint0[c]);
+        e1[c] = QuantizeBC6H(endpoint1[c]);
+
+        uint32_t const value0 = UnquantizeBC6H(e0[c]);
+        uint32_t const value1 = UnquantizeBC6H(e1[c]);
+        for (uint32_t idx = 0U; idx <= indexMax; idx++) {
+            palette[idx][c] = static_cast<float>(FinishUnquantizeBC6H(Interpolate(value0, value1, idx)));
+        }
+    }
+
+    return ChooseIndices(texels, palette, indices);
+}
+
+}
+
+namespace KRV {
+
+void EncodeBC7Block(uint8_t const *texels, uint8_t *block) {
+    Texels<4U> points{};
+    for (uint32_t i = 0U; i < BC_BLOCK_TEXELS; i++) {
+        for (uint32_t c = 0U; c < 4U; c++) {
+            points[i][c] = static_cast<float>(texels[4U*i + c]);
+        }
+    }
+
+    Texel<4U> endpoint0{}, endpoint1{};
+    FitLine(points, endpoint0, endpoint1);
+
+    BC7Endpoints endpoints{};
+    std::array<uint32_t, BC_BLOCK_TEXELS> indices{};
+    float error = EncodeBC7Endpoints(points, endpoint0, endpoint1, endpoints, indices);
+
+    for (uint32_t refinement = 0U; refinement < refinementsNum; refinement++) {
+        if (!RefineEndpoints(points, indices, endpoint0, endpoint1)) {
+            break;
+        }
+
+        BC7Endpoints refinedEndpoints{};
+        std::array<uint32_t, BC_BLOCK_TEXELS> refinedIndices{};
+        float const refinedError = EncodeBC7Endpoints(points, endpoint0, endpoint1, refinedEndpoints, refinedIndices);
+        if (refinedError >= error) {
+            break;
+        }
+
+        error = refinedError;
+        endpoints = refinedEndpoints;
+        indices = refinedIndices;
+    }
+
+    if ((indices[0] & anchorIndexBit) != 0U) {
+        std::swap(endpoints.e0, endpoints.e1);
+        std::swap(endpoints.p0, endpoints.p1);
+        for (auto &idx : indices) {
+            idx = indexMax - idx;
+        }
+    }
+
+    // Mode 6 is marked by six zero bits and a one
+    BlockWriter writer(block);
+    writer.Write(1U << 6U, 7U);
+    for (uint32_t c = 0U; c < 4U; c++) {
+        writer.Write(endpoints.e0[c], 7U);
+        writer.Write(endpoints.e1[c], 7U);
+    }
+    writer.Write(endpoints.p0, 1U);
+    writer.Write(endpoints.p1, 1U);
+
+    writer.Write(indices[0], 3U);
+    for (uint32_t i = 1U; i < BC_BLOCK_TEXELS; i++) {
+        writer.Write(indices[i], 4U);
+    }
+}
+
+void EncodeBC6HBlock(float const *texels, uint8_t *block) {
+    // Interpolation is linear in half float bits, so errors are measured there too
+    Texels<3U> points{};
+    for (uint32_t i = 0U; i < BC_BLOCK_TEXELS; i++) {
+        for (uint32_t c = 0U; c < 3U; c++) {
+            points[i][c] = static_cast<float>(FloatToHalfBits(texels[3U*i + c]));
+        }
+    }
+
+    Texel<3U> endpoint0{}, endpoint1{};
+    FitLine(points, endpoint0, endpoint1);
+
+    std::array<uint32_t, 3U> e0{}, e1{};
+    std::array<uint32_t, BC_BLOCK_TEXELS> indices{};
+    float error = EncodeBC6HEndpoints(points, endpoint0, endpoint1, e0, e1, indices);
+
+    for (uint32_t refinement = 0U; refinement < refinementsNum; refinement++) {
+        if (!RefineEndpoints(points, indices, endpoint0, endpoint1)) {
+            break;
+        }
+
+        std::array<uint32_t, 3U> refinedE0{}, refinedE1{};
+        std::array<uint32_t, BC_BLOCK_TEXELS> refinedIndices{};
+        float const refinedError = EncodeBC6HEndpoints(points, endpoint0, endpoint1, refinedE0, refinedE1, refinedIndices);
+        if (refinedError >= error) {
+            break;
+        }
+
+        error = refinedError;
+        e0 = refinedE0;
+        e1 = refinedE1;
+        indices = refinedIndices;
+    }
+
+    if ((indices[0] & anchorIndexBit) != 0U) {
+        std::swap(e0, e1);
+        for (auto &idx : indices) {
+            idx = indexMax - idx;
+        }
+    }
+
+    // Mode 11: one region with 10-bit endpoints, which are stored without deltas
+    BlockWriter writer(block);
+    writer.Write(0x03U, 5U);
+    for (uint32_t c = 0U; c < 3U; c++) {
+        writer.Write(e0[c], bc6hEndpointBits);
+    }
+    for (uint32_t c = 0U; c < 3U; c++) {
+        writer.Write(e1[c], bc6hEndpointBits);
+    }
+
+    writer.Write(indices[0], 3U);
+    for (uint32_t i = 1U; i < BC_BLOCK_TEXELS; i++) {
+        writer.Write(indices[i], 4U);
+    }
+}
+
+}
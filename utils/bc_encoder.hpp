@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace KRV {
+
+// Block encoders of BC7 and BC6H formats: a block keeps 4x4 texels in 16 bytes.
+// Only single subset modes are used (mode 6 of BC7 and mode 11 of BC6H). Blocks of a sky rarely have
+// sharp edges between several colours, so these modes keep most of the quality with a tiny search.
+constexpr uint32_t BC_BLOCK_DIMENSION = 4U;
+constexpr uint32_t BC_BLOCK_TEXELS = BC_BLOCK_DIMENSION*BC_BLOCK_DIMENSION;
+constexpr uint32_t BC_BLOCK_BYTES = 16U;
+
+// 16 RGBA8 texels in row order
+void EncodeBC7Block(uint8_t const *texels, uint8_t *block);
+
+// 16 RGB float texels in row order, they are clamped into the range of unsigned half floats
+void EncodeBC6HBlock(float const *texels, uint8_t *block);
+
+}
@@ -1,6 +1,6 @@
 #include "camera.hpp"
 
-#include "utils/window.hpp"
+#include <algorithm>
 #include <cmath>
 #include <numbers>
 
@@ -12,10 +12,9 @@ Camera::Camera(glm::vec3 position, glm::vec3 direction, float speed, float rotat
     azimutalAngle = std::atan2(this->direction.y, this->direction.x);
 }
 
-void Camera::Update() {
-    auto const &events = Window::GetInstance().GetEvents();
-
-    float time = clock.Reset();
+void Camera::Update(Window::Events const &events) {
+    // Time is limited, so the camera doesn't jump after the application waits for input
+    float time = std::min(static_cast<float>(clock.Reset()), 0.1F);
 
     constexpr static float PI_2 = std::numbers::pi/2.0F - 0.05F;
     if (events.keyboard.ARROW_UP) {polarAngle = std::clamp(polarAngle + rotation_speed*time, -PI_2, PI_2);}
@@ -37,6 +36,14 @@ void Camera::Update() {
     if (events.keyboard.Q) {position -= glm::vec3(0.0F, 0.0F, 1.0F)*speed*time*multiplier;}
 }
 
+void Camera::SetPose(glm::vec3 const &position, glm::vec3 const &direction) {
+    this->position = position;
+    this->direction = glm::normalize(direction);
+    polarAngle = std::asin(this->direction.z);
+    azimutalAngle = std::atan2(this->direction.y, this->direction.x);
+    clock.Reset();
+}
+
 glm::vec3 const & Camera::GetPosition() const {
     return position;
 }
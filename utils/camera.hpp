@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 
 #include "utils/clock.hpp"
+#include "utils/window.hpp"
 
 namespace KRV {
 
@@ -10,7 +11,11 @@ class Camera final {
 public:
     Camera(glm::vec3 position, glm::vec3 direction, float speed, float rotation_speed, float fov);
 
-    void Update();
+    // Move camera according to user input
+    void Update(Window::Events const &events);
+
+    // Place camera explicitly, it is used by scripted camera paths
+    void SetPose(glm::vec3 const &position, glm::vec3 const &direction);
 
     glm::vec3 const & GetPosition() const;
     glm::vec3 const & GetDirection() const;
@@ -0,0 +1,132 @@
+#include "camera_path.hpp"
+
+#include "my_vulkan/shaders/black_hole.in"
+
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <numbers>
+#include <stdexcept>
+
+namespace {
+
+constexpr char const *scenarioNames[KRV::CameraPath::SCENARIO_COUNT] = {
+    "FAR_ORBIT",
+    "CLOSE_APPROACH",
+    "EDGE_ON_DISK",
+    "INSIDE_PHOTON_SPHERE"
+};
+
+constexpr float PI = std::numbers::pi_v<float>;
+constexpr float RS = DEFAULT_BLACK_HOLE_RADIUS;
+
+// Position on a circle around Z axis (rotation axis of accretion disk)
+glm::vec3 OrbitPosition(float radius, float height, float angle) {
+    return glm::vec3(radius*std::cos(angle), radius*std::sin(angle), height);
+}
+
+}
+
+namespace KRV {
+
+char const * CameraPath::GetScenarioName(SCENARIO scenario) {
+    return scenarioNames[static_cast<uint32_t>(scenario)];
+}
+
+CameraPath CameraPath::FromScenario(SCENARIO scenario, uint32_t numOfPoses) {
+    CameraPath path;
+
+    for (uint32_t i = 0U; i < numOfPoses; i++) {
+        float const t = (numOfPoses > 1U) ? static_cast<float>(i)/static_cast<float>(numOfPoses - 1U) : 0.0F;
+
+        switch (scenario) {
+            case SCENARIO::FAR_ORBIT: {
+                // Full orbit far from the black hole, slightly above accretion disk
+                glm::vec3 const position = OrbitPosition(20.0F*RS, 3.0F*RS, 2.0F*PI*t);
+                path.AddPose(position, -position);
+                break;
+            }
+            case SCENARIO::CLOSE_APPROACH: {
+                // Radius decreases exponentially from 20rs to 2.5rs, camera looks at the black hole
+                float const radius = 20.0F*RS*std::pow(2.5F/20.0F, t);
+                glm::vec3 const position = OrbitPosition(radius, 0.1F*radius, 0.5F*PI*t);
+                path.AddPose(position, -position);
+                break;
+            }
+            case SCENARIO::EDGE_ON_DISK: {
+                // Camera is in the plane of accretion disk
+                glm::vec3 const position = OrbitPosition(12.0F*RS, 0.0F, 0.5F*PI*t);
+                path.AddPose(position, -position);
+                break;
+            }
+            case SCENARIO::INSIDE_PHOTON_SPHERE: {
+                // Photon sphere radius is 1.5rs, camera looks along the orbit
+                float const angle = 2.0F*PI*t;
+                glm::vec3 const position = OrbitPosition(1.3F*RS, 0.1F*RS, angle);
+                glm::vec3 const tangent = glm::vec3(-std::sin(angle), std::cos(angle), 0.1F);
+                path.AddPose(position, tangent);
+                break;
+            }
+            default:
+                throw std::runtime_error("CameraPath: Unknown scenario");
+        }
+    }
+
+    return path;
+}
+
+CameraPath CameraPath::Load(std::string const &fileName) {
+    std::ifstream file(fileName);
+    if (!file.is_open()) {
+        throw std::runtime_error(std::format("CameraPath: Cannot open file {}", fileName));
+    }
+
+    CameraPath path;
+    glm::vec3 position, direction;
+    while (file >> position.x >> position.y >> position.z >> direction.x >> direction.y >> direction.z) {
+        path.AddPose(position, direction);
+    }
+
+    if (path.IsEmpty()) {
+        throw std::runtime_error(std::format("CameraPath: File {} doesn't contain poses", fileName));
+    }
+
+    return path;
+}
+
+void CameraPath::Save(std::string const &fileName) const {
+    std::ofstream file(fileName);
+    if (!file.is_open()) {
+        throw std::runtime_error(std::format("CameraPath: Cannot open file {}", fileName));
+    }
+
+    for (auto const &pose : poses) {
+        file << std::format("{} {} {} {} {} {}\n", pose.position.x, pose.position.y, pose.position.z,
+            pose.direction.x, pose.direction.y, pose.direction.z);
+    }
+}
+
+void CameraPath::AddPose(glm::vec3 const &position, glm::vec3 const &direction) {
+    poses.push_back(Pose{
+        .position = position,
+        .direction = glm::normalize(direction)
+    });
+}
+
+void CameraPath::Clear() {
+    poses.clear();
+}
+
+CameraPath::Pose const & CameraPath::GetPose(uint64_t frameIndex) const {
+    return poses[frameIndex % poses.size()];
+}
+
+size_t CameraPath::GetSize() const {
+    return poses.size();
+}
+
+bool CameraPath::IsEmpty() const {
+    return poses.empty();
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace KRV {
+
+// Sequence of camera poses, which is replayed frame by frame.
+// A path is either generated from a scripted scenario or recorded in the interactive application.
+class CameraPath final {
+public:
+    struct Pose final {
+        glm::vec3 position = glm::vec3(0.0F);
+        glm::vec3 direction = glm::vec3(1.0F, 0.0F, 0.0F);
+    };
+
+    enum class SCENARIO : uint32_t {
+        FAR_ORBIT,
+        CLOSE_APPROACH,
+        EDGE_ON_DISK,
+        INSIDE_PHOTON_SPHERE,
+        COUNT // Must be the last one
+    };
+
+    static constexpr uint32_t SCENARIO_COUNT = static_cast<uint32_t>(SCENARIO::COUNT);
+
+    static char const * GetScenarioName(SCENARIO scenario);
+
+    // Scripted path, which consists of `numOfPoses` poses
+    static CameraPath FromScenario(SCENARIO scenario, uint32_t numOfPoses);
+
+    // Text format: one pose per line, "posX posY posZ dirX dirY dirZ"
+    static CameraPath Load(std::string const &fileName);
+    void Save(std::string const &fileName) const;
+
+    void AddPose(glm::vec3 const &position, glm::vec3 const &direction);
+    void Clear();
+
+    // Path is looped, so any frame index is valid for non-empty path
+    Pose const & GetPose(uint64_t frameIndex) const;
+    size_t GetSize() const;
+    bool IsEmpty() const;
+
+private:
+    std::vector<Pose> poses{};
+};
+
+}
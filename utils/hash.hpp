@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace KRV {
+
+// 64-bit FNV-1a hash, it is used as a key of on-disk caches.
+// Chain calls through `hash` argument to hash several objects.
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xCBF29CE484222325ULL;
+constexpr uint64_t FNV1A_PRIME = 0x00000100000001B3ULL;
+
+inline uint64_t HashFNV1a(void const *data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS) {
+    auto const *bytes = static_cast<uint8_t const *>(data);
+    for (size_t i = 0U; i < size; i++) {
+        hash = (hash ^ bytes[i])*FNV1A_PRIME;
+    }
+    return hash;
+}
+
+template<typename T>
+uint64_t HashFNV1aValue(T const &value, uint64_t hash = FNV1A_OFFSET_BASIS) {
+    return HashFNV1a(&value, sizeof(T), hash);
+}
+
+}
@@ -0,0 +1,158 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Queue of the current thread, it is set only for workers
+thread_local KRV::JobSystem const *pWorkerJobSystem = nullptr;
+thread_local uint32_t workerQueueIdx = 0U;
+
+}
+
+namespace KRV {
+
+bool JobSystem::Group::IsDone() const {
+    return pendingJobsNum.load() == 0U;
+}
+
+JobSystem::JobSystem(uint32_t workersNum) {
+    if (workersNum == 0U) {
+        workersNum = std::max(std::thread::hardware_concurrency(), 2U) - 1U;
+    }
+
+    for (uint32_t i = 0U; i <= workersNum; i++) {
+        queues.emplace_back(std::make_unique<Queue>());
+    }
+
+    for (uint32_t i = 0U; i < workersNum; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(sleepMutex);
+        isStopping = true;
+    }
+    sleepCV.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::Submit(Group &group, Job job) {
+    group.pendingJobsNum++;
+
+    {
+        // Counter is changed together with the deque, so it never underflows
+        Queue &queue = *queues[GetQueueIdx()];
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(Task{.job = std::move(job), .pGroup = &group});
+        queuedJobsNum++;
+    }
+
+    std::lock_guard lock(sleepMutex);
+    sleepCV.notify_one();
+}
+
+void JobSystem::Wait(Group &group) {
+    if (std::exception_ptr const exception = WaitNoThrow(group); exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+std::exception_ptr JobSystem::WaitNoThrow(Group &group) {
+    uint32_t const queueIdx = GetQueueIdx();
+
+    while (!group.IsDone()) {
+        if (RunJob(queueIdx)) {
+            continue;
+        }
+
+        // Jobs of the group are run by other threads, sleep until they finish or new jobs come
+        std::unique_lock lock(sleepMutex);
+        sleepCV.wait(lock, [&](){
+            return group.IsDone() || queuedJobsNum.load() > 0U;
+        });
+    }
+
+    std::lock_guard lock(group.exceptionMutex);
+    return std::exchange(group.exception, nullptr);
+}
+
+uint32_t JobSystem::GetWorkersNum() const {
+    return static_cast<uint32_t>(workers.size());
+}
+
+void JobSystem::WorkerLoop(uint32_t queueIdx) {
+    pWorkerJobSystem = this;
+    workerQueueIdx = queueIdx;
+
+    while (true) {
+        if (RunJob(queueIdx)) {
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        sleepCV.wait(lock, [&](){
+            return isStopping || queuedJobsNum.load() > 0U;
+        });
+
+        if (isStopping && queuedJobsNum.load() == 0U) {
+            return;
+        }
+    }
+}
+
+bool JobSystem::RunJob(uint32_t queueIdx) {
+    Task task{};
+    uint32_t const queuesNum = static_cast<uint32_t>(queues.size());
+
+    // The newest job of the own queue is hot in cache, the oldest jobs of others are stolen
+    for (uint32_t i = 0U; i < queuesNum && !task.job; i++) {
+        Queue &queue = *queues[(queueIdx + i) % queuesNum];
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        if (i == 0U) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queuedJobsNum--;
+    }
+
+    if (!task.job) {
+        return false;
+    }
+
+    try {
+        task.job();
+    } catch (...) {
+        std::lock_guard lock(task.pGroup->exceptionMutex);
+        if (!task.pGroup->exception) {
+            task.pGroup->exception = std::current_exception();
+        }
+    }
+
+    // Waiters of the group are woken by its last job
+    if (--task.pGroup->pendingJobsNum == 0U) {
+        std::lock_guard lock(sleepMutex);
+        sleepCV.notify_all();
+    }
+
+    return true;
+}
+
+uint32_t JobSystem::GetQueueIdx() const {
+    return (pWorkerJobSystem == this) ? workerQueueIdx : static_cast<uint32_t>(queues.size()) - 1U;
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace KRV {
+
+// Small work stealing job system. Every worker has its own deque: the owner takes the newest job,
+// idle workers steal the oldest ones of others. Threads, which wait for a group, run jobs meanwhile,
+// so jobs may submit and wait for nested jobs without deadlocks.
+class JobSystem final {
+public:
+    using Job = std::function<void()>;
+
+    // Jobs are waited by groups. Group must outlive its jobs.
+    class Group final {
+    public:
+        Group() = default;
+
+        Group(Group const &) = delete;
+        Group& operator=(Group const &) = delete;
+        Group(Group &&) = delete;
+        Group& operator=(Group &&) = delete;
+
+        ~Group() = default;
+
+        bool IsDone() const;
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<uint32_t> pendingJobsNum = 0U;
+        // The first exception of jobs is rethrown by Wait() or returned by WaitNoThrow()
+        std::mutex exceptionMutex{};
+        std::exception_ptr exception = nullptr;
+    };
+
+    // Zero number of workers means one per hardware thread except the calling one
+    explicit JobSystem(uint32_t workersNum = 0U);
+
+    JobSystem(JobSystem const &) = delete;
+    JobSystem& operator=(JobSystem const &) = delete;
+    JobSystem(JobSystem &&) = delete;
+    JobSystem& operator=(JobSystem &&) = delete;
+
+    // Queued jobs are finished before workers are joined
+    ~JobSystem();
+
+    void Submit(Group &group, Job job);
+    void Wait(Group &group);
+    // Exception of jobs is returned instead, e.g. for waiting in destructors
+    std::exception_ptr WaitNoThrow(Group &group);
+
+    uint32_t GetWorkersNum() const;
+
+private:
+    struct Task final {
+        Job job{};
+        Group *pGroup = nullptr;
+    };
+
+    struct Queue final {
+        std::mutex mutex{};
+        std::deque<Task> tasks{};
+    };
+
+    void WorkerLoop(uint32_t queueIdx);
+    // Return value is false if there is no queued job
+    bool RunJob(uint32_t queueIdx);
+    // Queue of the calling thread, threads outside of the system share the last one
+    uint32_t GetQueueIdx() const;
+
+    // One queue per worker and one for other threads
+    std::vector<std::unique_ptr<Queue>> queues{};
+    std::vector<std::thread> workers{};
+
+    std::atomic<uint32_t> queuedJobsNum = 0U;
+    std::mutex sleepMutex{};
+    std::condition_variable sleepCV{};
+    bool isStopping = false;
+};
+
+}
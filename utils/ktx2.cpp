@@ -0,0 +1,235 @@
+#include "ktx2.hpp"
+
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr std::array<uint8_t, 12U> ktx2Identifier = {0xABU, 'K', 'T', 'X', ' ', '2', '0', 0xBBU, '\r', '\n', 0x1AU, '\n'};
+
+// Identifier, header and index of data blocks, they are the same in memory and in the file
+struct Header final {
+    std::array<uint8_t, 12U> identifier{};
+    uint32_t vkFormat = 0U;
+    uint32_t typeSize = 0U;
+    uint32_t pixelWidth = 0U;
+    uint32_t pixelHeight = 0U;
+    uint32_t pixelDepth = 0U;
+    uint32_t layerCount = 0U;
+    uint32_t faceCount = 0U;
+    uint32_t levelCount = 0U;
+    uint32_t supercompressionScheme = 0U;
+    uint32_t dfdByteOffset = 0U;
+    uint32_t dfdByteLength = 0U;
+    uint32_t kvdByteOffset = 0U;
+    uint32_t kvdByteLength = 0U;
+    uint64_t sgdByteOffset = 0U;
+    uint64_t sgdByteLength = 0U;
+};
+static_assert(sizeof(Header) == 80U);
+
+struct LevelIndex final {
+    uint64_t byteOffset = 0U;
+    uint64_t byteLength = 0U;
+    uint64_t uncompressedByteLength = 0U;
+};
+static_assert(sizeof(LevelIndex) == 24U);
+
+// Block compressed levels are aligned to the size of a block
+constexpr uint64_t levelAlignment = KRV::BC_BLOCK_BYTES;
+
+// Data format descriptor values of Khronos Data Format specification
+constexpr uint32_t dfdVersion = 2U;
+constexpr uint32_t dfdBasicBlockSize = 40U;
+constexpr uint32_t dfdModelBC6H = 133U;
+constexpr uint32_t dfdModelBC7 = 134U;
+constexpr uint32_t dfdPrimariesBT709 = 1U;
+constexpr uint32_t dfdTransferLinear = 1U;
+constexpr uint32_t dfdQualifierFloat = 0x80U;
+
+// Basic descriptor block with a single sample of the whole 128-bit block
+std::array<uint32_t, 11U> GetDataFormatDescriptor(KRV::KTX2CubeMap::Format format) {
+    bool const isFloat = (format == KRV::KTX2CubeMap::Format::BC6H_UFLOAT);
+    uint32_t const model = isFloat ? dfdModelBC6H : dfdModelBC7;
+    uint32_t const blockDimension = KRV::BC_BLOCK_DIMENSION - 1U;
+
+    return {
+        sizeof(uint32_t) + dfdBasicBlockSize,
+        0U,
+        dfdVersion | (dfdBasicBlockSize << 16U),
+        model | (dfdPrimariesBT709 << 8U) | (dfdTransferLinear << 16U),
+        blockDimension | (blockDimension << 8U),
+        KRV::BC_BLOCK_BYTES,
+        0U,
+        ((KRV::BC_BLOCK_BYTES*8U - 1U) << 16U) | ((isFloat ? dfdQualifierFloat : 0U) << 24U),
+        0U,
+        0U,
+        isFloat ? std::bit_cast<uint32_t>(1.0F) : 0xFFFFFFFFU
+    };
+}
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1U)/alignment*alignment;
+}
+
+uint32_t GetMaxLevelsNum(uint32_t dimension) {
+    return std::bit_width(dimension);
+}
+
+bool IsSupportedFormat(uint32_t vkFormat) {
+    return vkFormat == static_cast<uint32_t>(KRV::KTX2CubeMap::Format::BC6H_UFLOAT) ||
+        vkFormat == static_cast<uint32_t>(KRV::KTX2CubeMap::Format::BC7_UNORM);
+}
+
+template<typename T>
+void Append(std::vector<uint8_t> &data, T const &value) {
+    auto const *bytes = reinterpret_cast<uint8_t const *>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+}
+
+namespace KRV {
+
+void KTX2CubeMap::Write(std::string const &fileName, Format format, uint32_t dimension, std::vector<std::vector<uint8_t>> const &levels) {
+    uint32_t const levelsNum = static_cast<uint32_t>(levels.size());
+    if (dimension == 0U || levelsNum == 0U || levelsNum > GetMaxLevelsNum(dimension)) {
+        throw std::runtime_error(std::format("[KTX2CubeMap] Invalid size {} with {} levels", dimension, levelsNum));
+    }
+
+    for (uint32_t levelIdx = 0U; levelIdx < levelsNum; levelIdx++) {
+        if (levels[levelIdx].size() != GetLevelSize(dimension, levelIdx)) {
+            throw std::runtime_error(std::format("[KTX2CubeMap] Invalid size of level {}", levelIdx));
+        }
+    }
+
+    auto const descriptor = GetDataFormatDescriptor(format);
+    constexpr char writerKey[] = "KTXwriter";
+    constexpr char writerValue[] = "KRV sky_converter";
+    uint32_t const keyValueSize = sizeof(writerKey) + sizeof(writerValue);
+
+    Header header {
+        .identifier = ktx2Identifier,
+        .vkFormat = static_cast<uint32_t>(format),
+        .typeSize = 1U,
+        .pixelWidth = dimension,
+        .pixelHeight = dimension,
+        .faceCount = FACES_NUM,
+        .levelCount = levelsNum
+    };
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(Header) + levelsNum*sizeof(LevelIndex));
+    header.dfdByteLength = static_cast<uint32_t>(sizeof(descriptor));
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    header.kvdByteLength = static_cast<uint32_t>(AlignUp(sizeof(uint32_t) + keyValueSize, sizeof(uint32_t)));
+
+    // Levels are stored from the smallest one, so a reader can stream a preview first
+    std::vector<LevelIndex> levelIndices(levelsNum);
+    uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+    for (uint32_t levelIdx = levelsNum; levelIdx-- > 0U;) {
+        offset = AlignUp(offset, levelAlignment);
+        levelIndices[levelIdx] = {
+            .byteOffset = offset,
+            .byteLength = levels[levelIdx].size(),
+            .uncompressedByteLength = levels[levelIdx].size()
+        };
+        offset += levels[levelIdx].size();
+    }
+
+    std::vector<uint8_t> data{};
+    data.reserve(offset);
+    Append(data, header);
+    for (auto const &levelIndex : levelIndices) {
+        Append(data, levelIndex);
+    }
+    Append(data, descriptor);
+    Append(data, keyValueSize);
+    data.insert(data.end(), std::begin(writerKey), std::end(writerKey));
+    data.insert(data.end(), std::begin(writerValue), std::end(writerValue));
+    data.resize(header.kvdByteOffset + header.kvdByteLength, 0U);
+
+    for (uint32_t levelIdx = levelsNum; levelIdx-- > 0U;) {
+        data.resize(levelIndices[levelIdx].byteOffset, 0U);
+        data.insert(data.end(), levels[levelIdx].begin(), levels[levelIdx].end());
+    }
+
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(reinterpret_cast<char const *>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file.good()) {
+        throw std::runtime_error(std::format("[KTX2CubeMap] Cannot write file {}", fileName));
+    }
+}
+
+size_t KTX2CubeMap::GetLevelSize(uint32_t dimension, uint32_t levelIdx) {
+    size_t const blocksNum = (std::max(dimension >> levelIdx, 1U) + BC_BLOCK_DIMENSION - 1U)/BC_BLOCK_DIMENSION;
+    return blocksNum*blocksNum*BC_BLOCK_BYTES*FACES_NUM;
+}
+
+KTX2CubeMap::KTX2CubeMap(std::string const &fileName) : file(fileName) {
+    if (!file.IsOpen() || file.GetSize() < sizeof(Header)) {
+        return;
+    }
+
+    Header header{};
+    std::memcpy(&header, file.GetData(), sizeof(Header));
+
+    bool const isSupported = header.identifier == ktx2Identifier && IsSupportedFormat(header.vkFormat) &&
+        header.typeSize == 1U && header.pixelWidth != 0U && header.pixelWidth == header.pixelHeight &&
+        header.pixelDepth == 0U && header.layerCount == 0U && header.faceCount == FACES_NUM &&
+        header.levelCount != 0U && header.levelCount <= GetMaxLevelsNum(header.pixelWidth) &&
+        header.supercompressionScheme == 0U;
+    if (!isSupported || file.GetSize() < sizeof(Header) + header.levelCount*sizeof(LevelIndex)) {
+        return;
+    }
+
+    std::vector<Level> fileLevels(header.levelCount);
+    for (uint32_t levelIdx = 0U; levelIdx < header.levelCount; levelIdx++) {
+        LevelIndex levelIndex{};
+        std::memcpy(&levelIndex, file.GetData() + sizeof(Header) + levelIdx*sizeof(LevelIndex), sizeof(LevelIndex));
+
+        // Offsets are checked before addition, so a broken file cannot overflow them
+        bool const isInside = levelIndex.byteOffset <= file.GetSize() &&
+            levelIndex.byteLength <= file.GetSize() - levelIndex.byteOffset;
+        if (!isInside || levelIndex.byteLength != GetLevelSize(header.pixelWidth, levelIdx)) {
+            return;
+        }
+
+        fileLevels[levelIdx] = {
+            .data = file.GetData() + levelIndex.byteOffset,
+            .size = static_cast<size_t>(levelIndex.byteLength)
+        };
+    }
+
+    format = static_cast<Format>(header.vkFormat);
+    dimension = header.pixelWidth;
+    levels = std::move(fileLevels);
+}
+
+bool KTX2CubeMap::IsValid() const {
+    return !levels.empty();
+}
+
+KTX2CubeMap::Format KTX2CubeMap::GetFormat() const {
+    return format;
+}
+
+uint32_t KTX2CubeMap::GetDimension() const {
+    return dimension;
+}
+
+uint32_t KTX2CubeMap::GetLevelsNum() const {
+    return static_cast<uint32_t>(levels.size());
+}
+
+KTX2CubeMap::Level KTX2CubeMap::GetLevel(uint32_t levelIdx) const {
+    return levels[levelIdx];
+}
+
+}
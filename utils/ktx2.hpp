@@ -0,0 +1,60 @@
+#pragma once
+
+#include "mapped_file.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace KRV {
+
+// Cube map in KTX 2.0 container. Only the subset used by the sky is supported: block compressed formats,
+// square faces, mip levels and no supercompression. Levels are stored exactly as Vulkan copies them from a buffer,
+// so a mapped file is uploaded without any conversion.
+class KTX2CubeMap final {
+public:
+    static constexpr uint32_t FACES_NUM = 6U;
+
+    // Values are the same as of VkFormat, so the container doesn't depend on Vulkan
+    enum class Format : uint32_t {
+        BC6H_UFLOAT = 143U,
+        BC7_UNORM = 145U
+    };
+
+    // Faces of a level follow each other in the order of cube map layers
+    struct Level final {
+        uint8_t const *data = nullptr;
+        size_t size = 0U;
+    };
+
+    // Every level keeps all faces, the first level is the biggest one. Throws if the file cannot be written.
+    static void Write(std::string const &fileName, Format format, uint32_t dimension, std::vector<std::vector<uint8_t>> const &levels);
+    // Bytes of all faces of a level
+    static size_t GetLevelSize(uint32_t dimension, uint32_t levelIdx);
+
+    // Failure to open or validate the file is not an error, it is checked by IsValid()
+    explicit KTX2CubeMap(std::string const &fileName);
+
+    KTX2CubeMap(KTX2CubeMap const &) = delete;
+    KTX2CubeMap& operator=(KTX2CubeMap const &) = delete;
+    KTX2CubeMap(KTX2CubeMap &&) = delete;
+    KTX2CubeMap& operator=(KTX2CubeMap &&) = delete;
+
+    ~KTX2CubeMap() = default;
+
+    bool IsValid() const;
+    Format GetFormat() const;
+    uint32_t GetDimension() const;
+    uint32_t GetLevelsNum() const;
+    Level GetLevel(uint32_t levelIdx) const;
+
+private:
+    MappedFile file;
+
+    Format format = Format::BC7_UNORM;
+    uint32_t dimension = 0U;
+    std::vector<Level> levels{};
+};
+
+}
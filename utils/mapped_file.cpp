@@ -0,0 +1,108 @@
+#include "mapped_file.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32, __linux__
+
+namespace KRV {
+
+MappedFile::MappedFile(std::string const &fileName) {
+
+#if defined(_WIN32)
+
+    HANDLE const file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        return;
+    }
+
+    HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0U, 0U, nullptr);
+    if (mapping == nullptr) {
+        return;
+    }
+    mappingHandle = mapping;
+
+    void const *view = MapViewOfFile(mapping, FILE_MAP_READ, 0U, 0U, 0U);
+    if (view == nullptr) {
+        return;
+    }
+
+    data = static_cast<uint8_t const *>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+#elif defined(__linux__)
+
+    fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return;
+    }
+
+    struct stat fileStat{};
+    if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+        return;
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (view == MAP_FAILED) {
+        return;
+    }
+
+    // File is read from the beginning to the end
+    madvise(view, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+    data = static_cast<uint8_t const *>(view);
+    size = static_cast<size_t>(fileStat.st_size);
+
+#endif // _WIN32, __linux__
+}
+
+MappedFile::~MappedFile() {
+
+#if defined(_WIN32)
+
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+
+#elif defined(__linux__)
+
+    if (data != nullptr) {
+        munmap(const_cast<uint8_t *>(data), size);
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+    }
+
+#endif // _WIN32, __linux__
+}
+
+bool MappedFile::IsOpen() const {
+    return data != nullptr;
+}
+
+uint8_t const * MappedFile::GetData() const {
+    return data;
+}
+
+size_t MappedFile::GetSize() const {
+    return size;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace KRV {
+
+// Read-only memory mapped file. Pages are loaded by OS on access, so a big file is streamed without a copy.
+class MappedFile final {
+public:
+    // Failure to open or map the file is not an error, it is checked by IsOpen()
+    explicit MappedFile(std::string const &fileName);
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile& operator=(MappedFile const &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile& operator=(MappedFile &&) = delete;
+
+    ~MappedFile();
+
+    bool IsOpen() const;
+    uint8_t const * GetData() const;
+    size_t GetSize() const;
+
+private:
+    uint8_t const *data = nullptr;
+    size_t size = 0U;
+
+#if defined(_WIN32)
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#elif defined(__linux__)
+    int fileDescriptor = -1;
+#endif // _WIN32, __linux__
+};
+
+}
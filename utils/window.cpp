@@ -69,6 +69,11 @@ void Window::PollEvents() {
     ProcessEvents();
 }
 
+void Window::WaitEvents() {
+    glfwWaitEvents();
+    ProcessEvents();
+}
+
 Window::Events const & Window::GetEvents() const {
     return events;
 }
@@ -91,6 +96,19 @@ void Window::ProcessEvents() {
     events.keyboard.ARROW_DOWN = (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS);
     events.keyboard.ARROW_LEFT = (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS);
     events.keyboard.ARROW_RIGHT = (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS);
+    events.keyboard.NUM_1 = (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS);
+    events.keyboard.NUM_2 = (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS);
+    events.keyboard.NUM_3 = (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS);
+    events.keyboard.NUM_4 = (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS);
+    events.keyboard.NUM_5 = (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS);
+    events.keyboard.NUM_6 = (glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS);
+    events.keyboard.NUM_7 = (glfwGetKey(window, GLFW_KEY_7) == GLFW_PRESS);
+    events.keyboard.PLUS = (glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS);
+    events.keyboard.MINUS = (glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS);
+    events.keyboard.R = (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS);
+    events.keyboard.T = (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS);
+    events.keyboard.G = (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS);
+    events.keyboard.V = (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS);
 
     // Mouse
     double curPos_x, curPos_y;
@@ -24,6 +24,19 @@ public:
             bool ARROW_DOWN = false;
             bool ARROW_LEFT = false;
             bool ARROW_RIGHT = false;
+            bool NUM_1 = false;
+            bool NUM_2 = false;
+            bool NUM_3 = false;
+            bool NUM_4 = false;
+            bool NUM_5 = false;
+            bool NUM_6 = false;
+            bool NUM_7 = false;
+            bool PLUS = false;
+            bool MINUS = false;
+            bool R = false;
+            bool T = false;
+            bool G = false;
+            bool V = false;
         };
 
         struct Mouse final {
@@ -48,6 +61,8 @@ public:
 
     bool ShouldClose();
     void PollEvents();
+    // Block until any event comes, it is used while there is nothing to render
+    void WaitEvents();
     Events const & GetEvents() const;
 
 private: